@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "emulation-thread.hpp"
+#include "motherboard.hpp"
+
+// Runs a ROM at normal speed against a simulated display that refreshes at a given rate but is
+// reported as the nearest whole number, like SDL does, and swaps at every refresh like the UI with
+// vsync. Prints the emulated frame rate and how many refreshes repeated or skipped a frame, for
+// each few seconds once the pacer had time to measure the swaps.
+//
+//   GameBoyFramePacerBench <boot ROM> <ROM> [refresh rate] [seconds]   (default 59.94 Hz, 40 s)
+int main(int argc, char** argv) {
+	using Clock = std::chrono::steady_clock;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <boot ROM> <ROM> [refresh rate] [seconds]\n", argv[0]);
+		return 1;
+	}
+
+	double refreshRate = argc > 3 ? atof(argv[3]) : 59.94;
+	unsigned int seconds = argc > 4 ? atoi(argv[4]) : 40;
+
+	Motherboard motherboard;
+
+	if (!motherboard.loadCartridge(argv[2]) || !motherboard.loadBootROM(argv[1])) {
+		return 1;
+	}
+
+	EmulationThread emulation(motherboard);
+	emulation.setRefreshRate((int) (refreshRate + 0.5));
+	emulation.start();
+
+	std::chrono::duration<double> interval(1.0 / refreshRate);
+	const unsigned int REPORT = 5;  // Seconds per line
+	unsigned int refreshesPerReport = (unsigned int) (refreshRate * REPORT + 0.5);
+
+	Clock::time_point start = Clock::now();
+	uint64_t last = motherboard.acquireFrame().sequence;
+	uint64_t reportStart = last;
+	unsigned int repeated = 0;
+	unsigned int skipped = 0;
+
+	for (unsigned int i = 1; i <= seconds * refreshesPerReport / REPORT; i++) {
+		std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(interval * i));
+
+		uint64_t sequence = motherboard.acquireFrame().sequence;
+		repeated += sequence == last;
+		skipped += sequence > last + 1;
+		last = sequence;
+
+		emulation.presented();
+
+		if (i % refreshesPerReport == 0) {
+			printf("%3u s: %.3f emulated fps, %u repeated and %u skipped of %u refreshes\n", i / refreshesPerReport * REPORT,
+					(last - reportStart) / (refreshesPerReport * interval.count()), repeated, skipped, refreshesPerReport);
+			reportStart = last;
+			repeated = 0;
+			skipped = 0;
+		}
+	}
+
+	emulation.stop();
+
+	return 0;
+}
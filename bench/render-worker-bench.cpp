@@ -0,0 +1,125 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "display.hpp"
+
+// Runs the display through whole frames while writing VRAM or OAM after every line, the way games
+// stream tiles and move sprites while the screen is drawn, and measures how long the emulation side
+// is blocked inside those writes. Writes go either to data no queued line reads (tiles 128-255,
+// sprites that are off screen) or to data the line just queued reads (its map row). The hash of the
+// last frame has to be the same for both ways of drawing.
+//
+//   GameBoyRenderWorkerBench [frames]
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	enum class Writes { None, Offscreen, Onscreen, Sprites };
+
+	const char * NAMES[] = {"no writes", "offscreen tiles", "onscreen map row", "offscreen sprites"};
+	const unsigned int WRITES_PER_LINE = 16;
+
+	void setup(Display& display) {
+		std::mt19937 rng(1);
+
+		for (auto& byte : display.VRAM) {
+			byte = rng();
+		}
+		for (unsigned int i = 0x1800; i < 0x2000; i++) {
+			display.VRAM[i] &= 0x7F;  // Maps only show tiles 0-127
+		}
+
+		// 20 sprites spread over the screen, the other 20 hidden above it
+		for (unsigned int i = 0; i < 40; i++) {
+			display.OAM[i * 4] = i < 20 ? 16 + (i * 7) % 144 : 0;
+			display.OAM[i * 4 + 1] = 8 + rng() % 160;
+			display.OAM[i * 4 + 2] = rng() & 0x7F;
+			display.OAM[i * 4 + 3] = rng() & 0x70;
+		}
+
+		display.indexSprites();
+		display.invalidateTiles();
+		display.LCDC = 0xF3;  // LCD, window (0x9C00), unsigned tiles, sprites and background on
+		display.BGP = 0xE4;
+		display.OBP0 = 0xD2;
+		display.OBP1 = 0x1B;
+		display.SCX = 3;
+		display.SCY = 5;
+		display.WX = 87;
+		display.WY = 100;
+	}
+
+	void run(bool threaded, Writes writes, unsigned int frames) {
+		static Display display;
+		setup(display);
+		display.setThreadedRendering(threaded);
+
+		Clock::duration blocked(0);
+		uint8_t value = 0;
+
+		// Settle on a frame boundary first
+		display.clock(154 * 456);
+
+		Clock::time_point start = Clock::now();
+
+		for (unsigned int frame = 0; frame < frames; frame++) {
+			for (unsigned int line = 0; line < 154; line++) {
+				display.clock(456);
+
+				if (writes == Writes::None || line >= 144) {
+					continue;
+				}
+
+				uint8_t y = display.SCY + line;
+				Clock::time_point writing = Clock::now();
+
+				for (unsigned int i = 0; i < WRITES_PER_LINE; i++) {
+					switch (writes) {
+						case Writes::Offscreen:
+							display.writeVRAM(0x0800 + (line * WRITES_PER_LINE + i) % 0x0800, value++);
+							break;
+						case Writes::Onscreen:
+							display.writeVRAM(0x1800 + (y / 8) * 32 + i, (value++) & 0x7F);
+							break;
+						case Writes::Sprites:
+							display.writeOAM(80 + (i % 20) * 4 + 1, value++);
+							break;
+						default:
+							break;
+					}
+				}
+
+				blocked += Clock::now() - writing;
+			}
+		}
+
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		double blockedSeconds = std::chrono::duration<double>(blocked).count();
+
+		display.setThreadedRendering(false);  // Draws what is still queued
+
+		uint64_t hash = 0xCBF29CE484222325;
+		for (const auto& row : *display.acquireFrame().pixels) {
+			for (uint8_t pixel : row) {
+				hash = (hash ^ pixel) * 0x100000001B3;
+			}
+		}
+
+		printf("%-8s %-18s %8.1f us/frame, %7.2f us/frame inside writes, frame hash %016llx\n",
+				threaded ? "worker" : "inline", NAMES[static_cast<int>(writes)], seconds / frames * 1e6,
+				blockedSeconds / frames * 1e6, (unsigned long long) hash);
+	}
+}
+
+int main(int argc, char** argv) {
+	unsigned int frames = argc > 1 ? atoi(argv[1]) : 2000;
+
+	for (Writes writes : {Writes::None, Writes::Offscreen, Writes::Onscreen, Writes::Sprites}) {
+		run(false, writes, frames);
+		run(true, writes, frames);
+	}
+
+	return 0;
+}
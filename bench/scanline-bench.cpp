@@ -0,0 +1,82 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "display.hpp"
+
+// Draws the same 16 lines over and over, each with a full set of 10 sprites and the window, and
+// reports the time per scanline. The hash of the lines shows whether the output changed, and with
+// every layer off they have to come out white.
+//
+//   GameBoyScanlineBench [lines]
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	void run(Display& display, const char * name, uint8_t lcdc, uint8_t bgp, long lines) {
+		display.LCDC = lcdc;
+		display.BGP = bgp;
+
+		Clock::time_point start = Clock::now();
+
+		for (long n = 0; n < lines; n++) {
+			display.LY = 60 + n % 16;
+			display.spriteSelect();
+			display.drawScanline(display.captureLine());
+		}
+
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		uint64_t hash = 0xCBF29CE484222325;
+		for (unsigned int y = 60; y < 76; y++) {
+			for (uint8_t pixel : display.frameBuffers[0][y]) {
+				hash = (hash ^ pixel) * 0x100000001B3;
+			}
+		}
+
+		printf("%-20s %7.1f ns/scanline, hash %016llx\n", name, seconds / lines * 1e9, (unsigned long long) hash);
+	}
+}
+
+int main(int argc, char** argv) {
+	long lines = argc > 1 ? atol(argv[1]) : 2000000;
+
+	static Display display;
+	std::mt19937 rng(1);
+
+	for (auto& byte : display.VRAM) {
+		byte = rng();
+	}
+
+	// All 40 sprites around lines 60-75, so every line has the maximum of 10
+	for (unsigned int i = 0; i < 40; i++) {
+		display.OAM[i * 4] = 16 + 60 + rng() % 8;
+		display.OAM[i * 4 + 1] = 8 + rng() % 160;
+		display.OAM[i * 4 + 2] = rng();
+		display.OAM[i * 4 + 3] = rng() & 0x7F;
+	}
+
+	display.indexSprites();
+	display.OBP0 = 0xD2;
+	display.OBP1 = 0x1B;
+	display.SCX = 3;
+	display.SCY = 5;
+	display.WX = 87;
+	display.WY = 60;
+
+	run(display, "all layers", 0xF3, 0xE4, lines);
+	run(display, "background off", 0xF2, 0x1B, lines);
+
+	// With nothing drawn the lines have to be white (shade 0), not what an inverted BGP maps colour 0 to
+	run(display, "nothing", 0xF0, 0x1B, 1000);
+	for (unsigned int y = 60; y < 76; y++) {
+		for (uint8_t pixel : display.frameBuffers[0][y]) {
+			if (pixel != 0) {
+				fprintf(stderr, "Line %u is not white with background and sprites off\n", y);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "emulation-thread.hpp"
+#include "motherboard.hpp"
+
+// Runs a ROM on the emulation thread in fast forward with a consumer that picks up the newest frame
+// at 60 Hz, like the UI, and reports the emulated frame rate and how many refreshes got a new frame.
+//
+//   GameBoyTurboBench <boot ROM> <ROM> [speed...]   (default speeds 2 4 8 0, 0 is uncapped)
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	const unsigned int REFRESHES = 120;
+	const std::chrono::microseconds REFRESH_INTERVAL(16667);
+
+	bool run(const char * bootFilename, const char * gameFilename, unsigned int speed) {
+		Motherboard motherboard;
+
+		if (!motherboard.loadCartridge(gameFilename) || !motherboard.loadBootROM(bootFilename)) {
+			return false;
+		}
+
+		EmulationThread emulation(motherboard);
+		emulation.setRefreshRate(1e6 / REFRESH_INTERVAL.count());
+		emulation.setSpeed(speed);
+		emulation.start();
+
+		Clock::time_point start = Clock::now();
+		uint64_t last = 0;
+		unsigned int fresh = 0;
+
+		for (unsigned int i = 0; i < REFRESHES; i++) {
+			std::this_thread::sleep_until(start + REFRESH_INTERVAL * (i + 1));
+
+			uint64_t sequence = motherboard.acquireFrame().sequence;
+			if (sequence != last) {
+				fresh++;
+				last = sequence;
+			}
+		}
+
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		emulation.stop();
+
+		printf("speed %-2u %8.0f emulated fps, %3u of %u refreshes got a new frame\n", speed,
+				last / seconds, fresh, REFRESHES);
+
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <boot ROM> <ROM> [speed...]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<unsigned int> speeds;
+	for (int i = 3; i < argc; i++) {
+		speeds.push_back(atoi(argv[i]));
+	}
+	if (speeds.empty()) {
+		speeds = {2, 4, 8, 0};
+	}
+
+	for (unsigned int speed : speeds) {
+		if (!run(argv[1], argv[2], speed)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
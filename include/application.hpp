@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 
+class InputQueue;
 class Window;
 
 class Application final {
@@ -12,15 +13,21 @@ class Application final {
 		Window& createWindow(const std::string& title,
 				int width, int height);
 
+		void setInputQueue(InputQueue* queue);
 		void pollEvents();
 
 		bool isRunning() const;
 
+		void setTurbo(bool enable);
+		bool isTurbo() const;
+
 		~Application();
 	private:
 		std::vector<Window*> windows;
+		InputQueue* input;
 
 		bool running;
+		bool turbo;
 
 		Application(const Application&) = delete;
 		Application(Application&&) = delete;
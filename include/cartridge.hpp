@@ -1,7 +1,16 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mapper.hpp"
+#include "rom-image.hpp"
+
+const size_t ROM_BANK_SIZE = 0x4000;
+const size_t RAM_BANK_SIZE = 0x2000;
 
 // TODO: define cartridge structure
 struct Header {
@@ -13,18 +22,34 @@ struct Header {
 };
 
 struct ROMBank {
-    uint8_t bankPtr;  // 0-255
-    std::array<std::array<uint8_t, 0x4000>, 256> bank;  // TODO: Verify correct arrray dimensions
+    unsigned int count;
 };
 
 struct RAMBank {
-    uint8_t bankPtr;  // 0-15
-    std::array<std::array<uint8_t, 0x4000>, 16> bank;  // TODO: Verify correct arrray dimensions
+    unsigned int count;
 };
 
+// Banks point straight into the ROM image and RAM sized from the header, bank N starts at
+// N * bank size so bank 0 is the start of the ROM image and is never stored twice.
+// The ROM image is immutable and can be shared between instances, only RAM and the bank
+// controller belong to the cartridge.
 struct Cartridge {
-    std::array<uint8_t, 0x4000> ROM;
+    Cartridge();
+
+    Cartridge(const Cartridge&) = delete;
+    Cartridge& operator=(const Cartridge&) = delete;
+
+    void load(std::shared_ptr<const ROMImage> image);
+
+    const uint8_t * getROMBank(unsigned int bank) const;
+    uint8_t * getRAMBank(unsigned int bank);
+
+    static size_t getRAMSize(uint8_t code);
+
     Header header;
+    std::shared_ptr<const ROMImage> ROM;
+    std::vector<uint8_t> RAM;
     ROMBank rombank;
     RAMBank rambank;
-};
\ No newline at end of file
+    std::unique_ptr<MBC::Mapper> mapper;  // Picked from the header type when the ROM is loaded
+};
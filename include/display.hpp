@@ -1,19 +1,80 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <vector>
+
+struct MemoryBus;
+class RenderWorker;
+class Scheduler;
 
 class Display {
 	public:
+		using FrameBuffer = std::array<std::array<uint8_t, 160>, 144>;
+
+		// A completed frame, numbered by the emulated frame it was drawn in (0 before the first one)
+		struct Frame {
+			const FrameBuffer * pixels;
+			uint64_t sequence;
+		};
+
 		Display();
 		~Display();
 
+		void registerIO(MemoryBus& memoryBus);
+		void loadScheduler(Scheduler * scheduler);
+
+		void sync();
+		void schedule();
+
 		void clock();
+		void clock(unsigned int count);
+		void update();
+		unsigned int cyclesUntilModeChange() const;
+		// Everything the renderer needs to draw one line, snapshotted at the end of pixel transfer
+		struct LineState {
+			uint8_t LY, LCDC, SCX, SCY, WX, BGP, OBP0, OBP1;
+			bool windowVisible;
+			uint8_t windowLine;
+			uint8_t spriteCount;
+			std::array<uint8_t, 10> sprites;  // OAM offsets
+		};
+
 		void spriteSelect();
-		void drawScanline();
+		void indexSprite(unsigned int sprite, uint8_t oldY, uint8_t newY);
+		void indexSprites();
+		LineState captureLine();
+		void drawScanline(const LineState& state);
+
+		void drawBackground(const LineState& state, std::array<uint8_t, 160>& line);
+		void drawWindow(const LineState& state, std::array<uint8_t, 160>& line);
+		bool drawSprites(const LineState& state, std::array<uint8_t, 160>& sprites);
+
+		void submitLine(const LineState& line);
+		void recordReads(const LineState& line, size_t ticket);
+		void recordMapRow(unsigned int map, unsigned int row, unsigned int first, uint8_t lcdc, size_t ticket);
+		void renderPending();
+		void setDeferredRendering(bool enable);
+		void setFrameSkip(unsigned int interval);
+		void requestFrame();
+		void startFrame();
+		void finishFrame();
+		void publishFrame(uint64_t sequence);
+		Frame acquireFrame();
+		bool isFramePending() const;
+		void setThreadedRendering(bool enable);
+		void setLayerCache(bool enable);
+		const uint8_t * getLayerRow(unsigned int map, uint8_t lcdc, uint8_t y);
 
-		void drawSpriteLine(uint8_t attr, uint8_t left, uint8_t right);
-		void drawBackgroundLine(uint8_t left, uint8_t right);
+		static void decodeTileRow(uint8_t low, uint8_t high, uint8_t * pixels);
+		void writeVRAM(const uint16_t offset, const uint8_t byte);
+		void writeOAM(const uint16_t offset, const uint8_t byte);
+		const uint8_t * getTileRow(unsigned int tile, unsigned int row);
+		void invalidateTiles();
+		static unsigned int getTileIndex(uint8_t lcdc, uint8_t tileNumber);
+		static std::array<uint8_t, 4> getPalette(uint8_t palette);
 
 		// LCDC stuff
 		uint16_t getBackgroundStartAddress();
@@ -28,11 +89,38 @@ class Display {
 		uint8_t spritePalette(uint8_t attr);
 		bool windowEnable();
 
-		std::array<std::array<uint8_t, 160>, 144> frameBuffer;
+		// Triple buffered so the emulation never waits for, or tears under, a consumer on another thread.
+		// The PPU draws into the back buffer, finishFrame() swaps it with the ready one and
+		// acquireFrame() swaps the ready one with the front buffer the consumer reads.
+		static constexpr unsigned int FRESH_FRAME = 0x04;  // Set in readyBuffer until the frame is acquired
+
+		std::array<FrameBuffer, 3> frameBuffers;
+		std::array<uint64_t, 3> frameSequences;
+		unsigned int backBuffer;
+		unsigned int frontBuffer;
+		std::atomic<unsigned int> readyBuffer;
+		uint64_t frameNumber;
+
 		std::array<uint8_t, 0x2000> VRAM;
 		std::array<uint8_t, 0xA0> OAM;
 
-		std::array<std::array<uint8_t, 160>, 144> getFrameBuffer();
+		static constexpr unsigned int TILE_COUNT = 384;  // 0x8000-0x97FF, 16 bytes each
+
+		// Tiles decoded to one colour index per pixel, redecoded on first use after a write
+		std::array<std::array<uint8_t, 64>, TILE_COUNT> tiles;
+		std::array<bool, TILE_COUNT> tileDirty;
+
+		// Optional 256x256 colour index layers of the 0x9800 and 0x9C00 tile maps, one 8x8 cell per map entry
+		static constexpr unsigned int LAYER_STRIDE = 256 + 160;  // Each row is followed by a copy of its first 160 pixels
+
+		bool layerCache;
+		std::vector<uint8_t> layers;
+		std::array<std::array<bool, 0x400>, 2> cellDirty;
+		std::array<std::array<bool, 32>, 2> rowDirty;  // Any dirty cell in a row of 32
+		std::array<uint8_t, 2> layerTileMode;  // LCDC bit 4 the cells of each layer were drawn with
+		std::array<bool, TILE_COUNT> tileChanged;  // Tiles written since the layers were last checked
+		bool tilesChanged;
+
 
 		uint8_t
 			LCDC,
@@ -53,7 +141,33 @@ class Display {
 		unsigned int cycles;
 		bool OAMAccess;
 
+		Scheduler * scheduler;
+		uint64_t synced;  // Cycle the display was last caught up to
+
+		// Bit n is set if sprite n covers the line, for 8x8 and 8x16 sprites. Updated on OAM writes
+		std::array<uint64_t, 144> spriteLines;
+		std::array<uint64_t, 144> tallSpriteLines;
+
 		std::array<int, 10> visibleSprites;
+		unsigned int spriteCount;
+		uint8_t windowLine;
+
+		bool deferred;
+		bool renderEnabled;  // Whether the current frame is drawn
+		unsigned int frameSkip;
+		unsigned int framesSkipped;
+		bool frameRequested;
+		std::array<LineState, 144> lineLog;
+		unsigned int pendingStart;  // Logged lines not drawn yet
+		unsigned int pendingEnd;
+
+		std::unique_ptr<RenderWorker> worker;  // Only while threaded rendering is on
+
+		// Ticket of the last queued line reading each tile, map row (32 per map) and OAM entry,
+		// writes only wait for that line instead of the whole queue
+		std::array<size_t, TILE_COUNT> tileReads;
+		std::array<size_t, 64> mapRowReads;
+		std::array<size_t, 40> spriteReads;
 
 		bool VRAMEnable;
 };
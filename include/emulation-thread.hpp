@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "frame-pacer.hpp"
+#include "joypad.hpp"
+
+class Motherboard;
+
+// Runs a motherboard frame by frame on its own thread, paced to the emulated frame rate. Completed
+// frames are picked up with Motherboard::acquireFrame() and input is sent through the queue,
+// nothing else of the motherboard may be touched while the thread is running.
+class EmulationThread final {
+	public:
+		explicit EmulationThread(Motherboard& motherboard);
+
+		void setRefreshRate(double refreshRate);
+		void setSpeed(unsigned int speed);
+		void presented();
+
+		void start();
+		void stop();
+
+		InputQueue& getInput();
+
+		~EmulationThread();
+	private:
+		Motherboard& motherboard;
+		InputQueue input;
+		FramePacer pacer;
+
+		std::atomic<bool> running;
+		std::atomic<unsigned int> speed;
+		std::thread thread;
+
+		// Measurement of the swap interval, only touched by the thread calling presented()
+		FramePacer::Clock::time_point measureStart;
+		FramePacer::Clock::time_point lastSwap;
+		unsigned int measuredSwaps;
+		bool measuring;
+		std::atomic<double> refreshRate;  // Last measured, 0 until the first measurement
+
+		void run();
+
+		EmulationThread(const EmulationThread&) = delete;
+		EmulationThread(EmulationThread&&) = delete;
+		EmulationThread& operator=(const EmulationThread&) = delete;
+};
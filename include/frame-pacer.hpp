@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+
+// Holds a loop to a fixed frame rate against absolute deadlines, so lateness in one frame is
+// made up in the next instead of accumulating. Sleeps until shortly before each deadline and
+// spins the rest, the spin margin adapts to how late the OS actually wakes the thread up.
+class FramePacer final {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr const double FRAME_RATE = 4194304.0 / 70224;  // About 59.73 Hz
+
+		FramePacer();
+
+		void setRate(double rate);
+		void setSpeed(unsigned int speed);
+		void matchRefreshRate(double refreshRate);
+		void reset();
+
+		void wait();
+
+		double getRate() const;
+	private:
+		Clock::duration period;
+		Clock::time_point deadline;
+		Clock::duration margin;  // Time left for spinning after the sleep
+
+		double rate;
+		unsigned int speed;
+
+		void updatePeriod();
+};
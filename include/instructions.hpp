@@ -2,10 +2,9 @@
 
 #include "singleton.hpp"
 
+#include <array>
 #include <cstdint>
 
-#include <functional>
-
 class Registers;
 class MemoryBus;
 
@@ -13,16 +12,20 @@ class Instructions final : public Singleton<Instructions> {
 	public:
 		static constexpr const uint8_t PREFIX_BYTE = 0xCB;
 
-		using Instruction = std::function<void(unsigned int&, Registers&, MemoryBus&)>;
+		// Plain function pointer so dispatch is a single indirect call with no
+		// type erasure; every table entry is a captureless lambda
+		using Instruction = void (*)(unsigned int&, Registers&, MemoryBus&);
 
 		Instructions();
 
-		Instruction fetchInstruction(uint8_t instructionByte, bool prefixByte);
+		inline Instruction fetchInstruction(uint8_t instructionByte, bool prefixByte) const {
+			return prefixByte ? prefixed[instructionByte] : nonPrefixed[instructionByte];
+		}
 
 		~Instructions();
 	private:
-		Instruction prefixed[0xFF];
-		Instruction nonPrefixed[0xFF];
+		std::array<Instruction, 0x100> prefixed;
+		std::array<Instruction, 0x100> nonPrefixed;
 
 		void initPrefixed();
 		void initNonPrefixed();
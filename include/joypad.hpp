@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct MemoryBus;
+
+enum class Button : uint8_t {
+	Right, Left, Up, Down,  // Direction keys, P14 low
+	A, B, Select, Start     // Button keys, P15 low
+};
+
+struct InputEvent {
+	Button button;
+	bool pressed;
+};
+
+// Carries button presses from the UI thread to the emulation thread. Single producer single
+// consumer lock-free ring, events are dropped when the emulation thread stops draining it.
+class InputQueue final {
+	public:
+		static constexpr const size_t CAPACITY = 64;  // Must be a power of two
+
+		InputQueue();
+
+		bool push(const InputEvent& event);
+		bool pop(InputEvent& event);
+	private:
+		std::array<InputEvent, CAPACITY> buffer;
+
+		std::atomic<size_t> head;
+		std::atomic<size_t> tail;
+};
+
+// P1/JOYP (0xFF00), the selected key group reads back active low in the lower nibble
+class Joypad {
+	public:
+		Joypad();
+
+		void registerIO(MemoryBus& memoryBus);
+
+		void setButton(Button button, bool pressed);
+
+		uint8_t select;   // P14/P15 as last written
+		uint8_t buttons;  // One bit per Button, set while pressed
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+
+struct Cartridge;
+
+namespace MBC {
+	class Mapper;
+	class ROMOnly;
+	class MBC1;
+	class MBC2;
+	class MBC3;
+	class MBC5;
+
+	std::unique_ptr<Mapper> create(Cartridge& cartridge);
+}
+
+// Memory bank controller of a cartridge. The bank base pointers are only recalculated when a
+// control register is written, the memory bus maps them straight into its page table.
+class MBC::Mapper {
+	public:
+		Mapper(Cartridge& cartridge);
+		virtual ~Mapper();
+
+		// Write to 0x0000-0x7FFF, returns true when the memory map changed
+		virtual bool write(const uint16_t address, const uint8_t byte) = 0;
+
+		// External RAM accesses that can't go through the page table (disabled RAM, RTC registers, MBC2 RAM)
+		virtual uint8_t readRAM(const uint16_t address) const;
+		virtual void writeRAM(const uint16_t address, const uint8_t byte);
+
+		const uint8_t * getROMBank0() const;
+		const uint8_t * getROMBankN() const;
+		uint8_t * getRAMBank() const;  // nullptr while external RAM isn't directly mapped
+
+	protected:
+		Cartridge& cartridge;
+
+		const uint8_t * ROMBank0;
+		const uint8_t * ROMBankN;
+		uint8_t * RAMBank;
+
+		bool setBanks(unsigned int bank0, unsigned int bankN, unsigned int RAMBankNumber, bool RAMEnable);
+};
+
+// No bank controller, 32K of ROM and optionally 8K of RAM
+class MBC::ROMOnly : public MBC::Mapper {
+	public:
+		ROMOnly(Cartridge& cartridge);
+
+		bool write(const uint16_t address, const uint8_t byte) override;
+};
+
+class MBC::MBC1 : public MBC::Mapper {
+	public:
+		MBC1(Cartridge& cartridge);
+
+		bool write(const uint16_t address, const uint8_t byte) override;
+
+	private:
+		bool RAMEnable;
+		uint8_t bankLow;   // 5 bits
+		uint8_t bankHigh;  // 2 bits, upper ROM bank bits or RAM bank
+		uint8_t mode;
+
+		bool update();
+};
+
+// 512x4 bits of RAM built into the controller, echoed across the whole external RAM window
+class MBC::MBC2 : public MBC::Mapper {
+	public:
+		MBC2(Cartridge& cartridge);
+
+		bool write(const uint16_t address, const uint8_t byte) override;
+
+		uint8_t readRAM(const uint16_t address) const override;
+		void writeRAM(const uint16_t address, const uint8_t byte) override;
+
+	private:
+		std::array<uint8_t, 0x200> RAM;
+		bool RAMEnable;
+		uint8_t bank;
+};
+
+// Up to 2M of ROM, 32K of RAM and a real time clock
+class MBC::MBC3 : public MBC::Mapper {
+	public:
+		MBC3(Cartridge& cartridge);
+
+		bool write(const uint16_t address, const uint8_t byte) override;
+
+		uint8_t readRAM(const uint16_t address) const override;
+		void writeRAM(const uint16_t address, const uint8_t byte) override;
+
+	private:
+		bool RAMEnable;
+		uint8_t bank;
+		uint8_t select;  // 0x00-0x03 RAM bank, 0x08-0x0C RTC register
+		uint8_t latch;
+
+		// RTC runs on host time, stored as seconds counted before `RTCStart`
+		int64_t RTCSeconds;
+		std::time_t RTCStart;
+		bool RTCHalt;
+		bool RTCCarry;
+		std::array<uint8_t, 5> RTCLatched;  // S, M, H, DL, DH
+
+		int64_t RTCNow() const;
+		void RTCLatch();
+
+		bool update();
+};
+
+class MBC::MBC5 : public MBC::Mapper {
+	public:
+		MBC5(Cartridge& cartridge);
+
+		bool write(const uint16_t address, const uint8_t byte) override;
+
+	private:
+		bool RAMEnable;
+		uint16_t bank;  // 9 bits
+		uint8_t RAMBankNumber;
+
+		bool update();
+};
@@ -6,19 +6,68 @@
 #include "cartridge.hpp"
 #include "display.hpp"
 
+const unsigned int PAGE_SIZE = 0x100;
+const unsigned int PAGE_COUNT = 0x100;
+const unsigned int IO_COUNT = 0x80;  // 0xFF00-0xFF7F
+
+// Handler for a single IO register. Plain registers only point `data` at their storage, registers
+// with side effects set the callbacks, which take precedence over `data`
+struct IOPort {
+	using Read = uint8_t (*)(void * context, const uint16_t address);
+	using Write = void (*)(void * context, const uint16_t address, const uint8_t byte);
+
+	uint8_t * data;
+	Read read;
+	Write write;
+	void * context;
+};
+
 struct MemoryBus {
+	MemoryBus();
+
+	// Plain memory is accessed directly through the page tables, special pages (MBC control,
+	// unmapped external RAM, OAM, IO, HRAM) have a null entry and fall back to the handlers
+	inline uint8_t read(const uint16_t address) const {
+		if (const uint8_t * page = readPages[address >> 8]) {
+			return page[address & 0xFF];
+		}
+		return readHandler(address);
+	}
 
-	uint8_t read(const uint16_t address) const;
-	void write(const uint16_t address, const uint8_t byte);
+	inline void write(const uint16_t address, const uint8_t byte) {
+		if (uint8_t * page = writePages[address >> 8]) {
+			page[address & 0xFF] = byte;
+			return;
+		}
+		writeHandler(address, byte);
+	}
+
+	uint8_t readHandler(const uint16_t address) const;
+	void writeHandler(const uint16_t address, const uint8_t byte);
 
 	uint8_t readIO(const uint16_t address) const;
 	void writeIO(const uint16_t address, const uint8_t byte);
 
+	void registerIO(const uint16_t address, uint8_t * data);
+	void registerIO(const uint16_t address, IOPort::Read read, IOPort::Write write, void * context);
+	void unmapped(const uint16_t address, const char * access) const;
+
 	uint8_t operator[](const uint16_t address) const;
 
 	void loadCartridge(Cartridge * cartridge);
 	void loadDisplay(Display * display);
 
+	void mapPages();
+	void mapRead(const uint16_t start, const unsigned int size, const uint8_t * memory);
+	void mapWrite(const uint16_t start, const unsigned int size, uint8_t * memory);
+
+	std::array<const uint8_t *, PAGE_COUNT> readPages;
+	std::array<uint8_t *, PAGE_COUNT> writePages;
+
+	std::array<IOPort, IO_COUNT> io;
+	std::array<uint8_t, IO_COUNT> IO;  // Storage for registers that have no emulated component yet
+	mutable std::array<bool, IO_COUNT> ioReported;
+
 	std::array<uint8_t, 0x2000> WRAM;
 	std::array<uint8_t, 0x80> HRAM;
 	bool interruptsEnable;
@@ -26,6 +75,6 @@ struct MemoryBus {
 	Cartridge * cartridge;
 	Display * display;
 
-	bool ERAMEnable;
-	uint8_t bankingMode;
+	std::array<uint8_t, 0x100> bootROM;
+	bool bootROMEnable;
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <fstream>
@@ -10,11 +11,14 @@
 
 #include "cartridge.hpp"
 #include "display.hpp"
+#include "joypad.hpp"
 #include "memory-bus.hpp"
 #include "processor.hpp"
 #include "registers.hpp"
+#include "scheduler.hpp"
 
-const int BOOT_ROM_SIZE = 0xFF;
+const int BOOT_ROM_SIZE = 0x100;
+const unsigned int CYCLES_PER_FRAME = 70224;  // 154 lines of 456 dots
 
 class Motherboard {
 	public:
@@ -22,14 +26,27 @@ class Motherboard {
 		~Motherboard();
 
 		void clock();
+		unsigned int runFor(unsigned int cycles);
+		void runUntil(uint64_t timestamp);
+		void runFrame();
 
-		void loadBootROM();
-		void loadCartridge(std::string filename);
+		Scheduler& getScheduler();
+
+		bool loadBootROM(std::string filename = "../res/DMG_ROM.bin");
+		bool loadCartridge(std::string filename);
 
 		void loadMemory();
 		void loadInterrupts();
 
-		std::array<std::array<uint8_t, 160>, 144> getFrameBuffer();
+		Display::Frame acquireFrame();
+		bool isFramePending() const;
+		void setDeferredRendering(bool enable);
+		void setFrameSkip(unsigned int interval);
+		void requestFrame();
+		void setThreadedRendering(bool enable);
+		void setLayerCache(bool enable);
+
+		void setButton(Button button, bool pressed);
 
 		std::string getTitle();
 	private:
@@ -37,6 +54,12 @@ class Motherboard {
 		MemoryBus * memoryBus;
 		Cartridge cartridge;
 		Display display;
+		Joypad joypad;
+		Scheduler scheduler;
+
+		bool frameComplete;
+
+		void handleEvent(Event event);
 
 		std::vector<uint8_t> readFile(std::string filename);
 };
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "display.hpp"
+
+// Pixel layouts a frame can be converted to. RGBA8888 and RGB888 are bytes in R, G, B(, A)
+// order, RGB565 is one native endian 16 bit word per pixel (GL_UNSIGNED_SHORT_5_6_5).
+enum class PixelFormat {
+	RGBA8888,
+	RGB888,
+	RGB565
+};
+
+// Row kernels a palette converts with, Best is the fastest the CPU supports
+enum class InstructionSet {
+	Best,
+	Scalar,
+	SSE2,
+	AVX2
+};
+
+// Turns the display's 2 bit shades into displayable pixels through a 4 color palette, writing
+// straight into the caller's (upload) buffer. Uses AVX2 or SSE2 kernels when the CPU has them.
+class Palette final {
+	public:
+		Palette();
+		explicit Palette(const std::array<uint32_t, 4>& colors);
+
+		void setColor(unsigned int shade, uint32_t rgb);
+		uint32_t getColor(unsigned int shade) const;
+
+		// pitch is the distance between rows in bytes, 0 for tightly packed rows
+		void convert(const Display::FrameBuffer& frame, void * out, PixelFormat format, size_t pitch = 0) const;
+
+		// Forces one set of kernels, false if the build or CPU does not have it
+		bool setInstructionSet(InstructionSet set);
+
+		static size_t getBytesPerPixel(PixelFormat format);
+	private:
+		std::array<uint32_t, 4> colors;  // 0xRRGGBB for shades 0-3
+		InstructionSet instructionSet;
+
+		// The same colors already laid out the way each format stores them
+		std::array<uint32_t, 4> rgba;
+		std::array<std::array<uint8_t, 3>, 4> rgb;
+		std::array<uint16_t, 4> rgb565;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "registers.hpp"
 #include "memory-bus.hpp"
 
@@ -8,6 +10,8 @@ class Processor final {
 		Processor();
 
 		void step();
+		unsigned int execute();
+		unsigned int run(unsigned int budget);
 
 		MemoryBus& getMemory();
 		const MemoryBus& getMemory() const;
@@ -20,6 +24,8 @@ class Processor final {
 		Registers registers;
 
 		unsigned int cycles;
+		uint64_t totalCycles;
+		bool locked;
 
 		MemoryBus memory;
 
@@ -19,6 +19,8 @@ class RenderDevice final {
 	private:
 		SDL_GLContext context;
 
+		uint32_t quadBuffer;  // Vertex buffer of the full screen quad
+
 		RenderDevice(const RenderDevice&) = delete;
 		RenderDevice(RenderDevice&&) = delete;
 		RenderDevice& operator=(const RenderDevice&) = delete;
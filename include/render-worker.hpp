@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+#include "display.hpp"
+
+// Draws a display's scanlines on a separate thread while the emulation thread keeps running.
+// Line snapshots are handed over through a single producer single consumer lock-free ring.
+// push() returns a ticket for the line, anything a queued line reads (VRAM, OAM, tile cache)
+// may only be changed by the emulation thread after waitFor() its ticket has returned. Frames
+// are published by the worker once their last line is drawn.
+class RenderWorker final {
+	public:
+		static constexpr const size_t CAPACITY = 256;  // Must be a power of two
+
+		explicit RenderWorker(Display& display);
+
+		size_t push(const Display::LineState& line);
+		void publish(uint64_t frame);
+		void waitFor(size_t ticket);
+		void wait();
+
+		~RenderWorker();
+	private:
+		// A line to draw, or the end of a frame to publish
+		struct Job {
+			Display::LineState line;
+			bool publish;
+			uint64_t frame;
+		};
+
+		Display& display;
+
+		std::array<Job, CAPACITY> buffer;
+
+		std::atomic<size_t> head;
+		std::atomic<size_t> tail;
+		std::atomic<bool> running;
+		std::atomic<bool> sleeping;
+
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::thread thread;
+
+		void enqueue(const Job& job);
+		void run();
+
+		RenderWorker(const RenderWorker&) = delete;
+		RenderWorker(RenderWorker&&) = delete;
+		RenderWorker& operator=(const RenderWorker&) = delete;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "rom-image.hpp"
+#include "singleton.hpp"
+
+// Process-wide cache of immutable ROM images keyed by a hash of their contents, so every
+// instance running the same game shares one image. Files already loaded are found by their
+// identity (device, inode, size and modification time) without reading them again. The cache
+// only holds weak references, an image is released when the last cartridge using it is destroyed.
+class ROMCache final : public Singleton<ROMCache> {
+	public:
+		ROMCache();
+
+		std::shared_ptr<const ROMImage> load(const std::string& filename);
+
+		size_t size();
+
+		~ROMCache();
+	private:
+		struct FileIdentity {
+			uint64_t device;
+			uint64_t inode;
+			uint64_t size;
+			int64_t modified;
+
+			bool operator<(const FileIdentity& other) const;
+			bool operator==(const FileIdentity& other) const;
+		};
+
+		std::unordered_multimap<uint64_t, std::weak_ptr<const ROMImage>> images;
+		std::map<FileIdentity, std::weak_ptr<const ROMImage>> files;
+		std::mutex mutex;
+
+		static bool identify(const std::string& filename, FileIdentity& identity);
+		static uint64_t hash(const uint8_t * data, size_t length);
+		void prune();
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only ROM file contents. Regular files whose size is a whole number of 16K banks are memory
+// mapped so banks point straight into the page cache, anything else (pipes, odd sizes, Windows) is
+// read into a buffer padded to whole banks.
+class ROMImage final {
+	public:
+		ROMImage();
+
+		bool open(const std::string& filename);
+
+		const uint8_t * data() const;
+		size_t size() const;
+		bool isMapped() const;
+
+		ROMImage(ROMImage&& other);
+		ROMImage& operator=(ROMImage&& other);
+
+		~ROMImage();
+	private:
+		const uint8_t * mapping;
+		size_t length;
+		std::vector<uint8_t> buffer;
+
+		bool map(int fd, size_t fileSize);
+		bool readBuffered(const std::string& filename);
+		void close();
+
+		ROMImage(const ROMImage&) = delete;
+		ROMImage& operator=(const ROMImage&) = delete;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Components that can register a deadline with the scheduler, at most one pending deadline each
+enum class Event : uint8_t {
+	PPU,       // Next display mode transition
+	FrameEnd,  // End of the current 70224 cycle frame
+	Timer,     // Timer overflow
+	DMA,       // End of an OAM DMA transfer
+	APU,       // Next audio frame sequencer step
+	COUNT
+};
+
+// Single authoritative clock for the system, keyed by an absolute T-cycle count.
+// Deadlines are kept in a binary min-heap; rescheduling or cancelling an event leaves its old
+// entry in the heap, which is skipped when it reaches the top.
+class Scheduler final {
+	public:
+		static constexpr const uint64_t NEVER = UINT64_MAX;
+
+		Scheduler();
+
+		uint64_t now() const;
+		void advance(unsigned int cycles);
+
+		void schedule(Event event, uint64_t timestamp);
+		void cancel(Event event);
+		bool isScheduled(Event event) const;
+		uint64_t deadline(Event event) const;
+
+		uint64_t nextDeadline();
+		bool popDue(Event& event);
+
+		~Scheduler();
+	private:
+		struct Entry {
+			uint64_t timestamp;
+			Event event;
+
+			bool operator>(const Entry& other) const;
+		};
+
+		uint64_t cycle;
+
+		std::vector<Entry> heap;
+		std::array<uint64_t, (size_t) Event::COUNT> deadlines;
+
+		void discardStale();
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 class Bitmap;
 
@@ -13,6 +14,17 @@ class Texture final {
 
 		uint32_t getID();
 
+		// Replaces the whole image in place, data has the format the texture was created with
+		void update(const void* data);
+
+		// Lets the caller write the next image straight into the upload buffer. With pixel
+		// buffers that is mapped driver memory, double buffered so the upload of the last
+		// image can still be in flight.
+		void* beginUpdate();
+		void endUpdate();
+
+		void usePixelBuffers(bool enable);
+
 		uint32_t getWidth() const;
 		uint32_t getHeight() const;
 
@@ -22,4 +34,19 @@ class Texture final {
 
 		uint32_t width;
 		uint32_t height;
+
+		uint32_t pixelFormat;
+		uint32_t dataType;
+
+		uint32_t pixelBuffers[2];
+		unsigned int currentBuffer;
+		bool pixelBuffersEnabled;
+
+		std::vector<uint8_t> staging;  // Upload buffer when pixel buffers are off
+
+		uint32_t getDataSize() const;
+
+		Texture(const Texture&) = delete;
+		Texture(Texture&&) = delete;
+		Texture& operator=(const Texture&) = delete;
 };
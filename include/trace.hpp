@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "singleton.hpp"
+
+// Fixed size binary record written for every executed instruction
+struct TraceRecord {
+	uint64_t cycle;  // T-cycle count when the instruction started
+	uint16_t PC;
+	uint16_t AF;
+	uint16_t BC;
+	uint16_t DE;
+	uint16_t HL;
+	uint16_t SP;
+	uint8_t opcode;
+	uint8_t prefixed;
+	uint8_t padding[2];
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must stay a fixed 24 byte record");
+
+// Execution trace, only compiled into the processor when built with -DGAMEBOY_TRACE=ON.
+// Single producer (the processor) single consumer (flush()) lock-free ring buffer, records
+// are dropped rather than blocking the emulator when the consumer falls behind.
+class Trace final : public Singleton<Trace> {
+	public:
+		static constexpr const size_t CAPACITY = 1 << 16;  // Must be a power of two
+
+		Trace();
+
+		inline void record(const TraceRecord& record) {
+			size_t head = this->head.load(std::memory_order_relaxed);
+
+			if (head - tail.load(std::memory_order_acquire) == CAPACITY) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			buffer[head & (CAPACITY - 1)] = record;
+			this->head.store(head + 1, std::memory_order_release);
+		}
+
+		bool open(const std::string& filename);
+		size_t flush();
+		void close();
+
+		uint64_t getDropped() const;
+
+		static void decode(FILE * in, FILE * out);
+
+		~Trace();
+	private:
+		std::array<TraceRecord, CAPACITY> buffer;
+
+		std::atomic<size_t> head;
+		std::atomic<size_t> tail;
+		std::atomic<uint64_t> dropped;
+
+		FILE * file;
+};
@@ -14,6 +14,7 @@ class Window final {
 
 		int getWidth() const;
 		int getHeight() const;
+		int getRefreshRate() const;
 
 		~Window();
 	protected:
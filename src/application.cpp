@@ -1,11 +1,30 @@
 #include "application.hpp"
 
+#include "joypad.hpp"
 #include "window.hpp"
 
 #include <SDL2/SDL.h>
 
+namespace {
+	bool mapKey(SDL_Keycode key, Button& button) {
+		switch (key) {
+			case SDLK_RIGHT:     button = Button::Right; return true;
+			case SDLK_LEFT:      button = Button::Left; return true;
+			case SDLK_UP:        button = Button::Up; return true;
+			case SDLK_DOWN:      button = Button::Down; return true;
+			case SDLK_x:         button = Button::A; return true;
+			case SDLK_z:         button = Button::B; return true;
+			case SDLK_BACKSPACE: button = Button::Select; return true;
+			case SDLK_RETURN:    button = Button::Start; return true;
+			default:             return false;
+		}
+	}
+}
+
 Application::Application()
-		: running(true) {
+		: input(nullptr)
+		, running(true)
+		, turbo(false) {
 	SDL_Init(SDL_INIT_EVERYTHING);
 }
 
@@ -17,14 +36,31 @@ Window& Application::createWindow(const std::string& title,
 	return *win;
 }
 
+// Key presses are forwarded to the queue as button events, if one is set
+void Application::setInputQueue(InputQueue* queue) {
+	input = queue;
+}
+
 void Application::pollEvents() {
 	SDL_Event e;
+	Button button;
 
 	while (SDL_PollEvent(&e)) {
 		switch (e.type) {
 			case SDL_QUIT:
 				running = false;
 				break;
+			case SDL_KEYDOWN:
+				if (e.key.keysym.sym == SDLK_TAB && !e.key.repeat) {
+					turbo = !turbo;
+					break;
+				}
+				// Fall through
+			case SDL_KEYUP:
+				if (input && !e.key.repeat && mapKey(e.key.keysym.sym, button)) {
+					input->push({button, e.type == SDL_KEYDOWN});
+				}
+				break;
 		}
 	}
 }
@@ -33,6 +69,15 @@ bool Application::isRunning() const {
 	return running;
 }
 
+// Fast forward, toggled with Tab
+void Application::setTurbo(bool enable) {
+	turbo = enable;
+}
+
+bool Application::isTurbo() const {
+	return turbo;
+}
+
 Application::~Application() {
 	for (auto* win  : windows) {
 		delete win;
@@ -0,0 +1,49 @@
+#include "cartridge.hpp"
+
+Cartridge::Cartridge()
+        : header()
+        , rombank({0})
+        , rambank({0}) {}
+
+// The header must already be parsed to size the RAM and pick the bank controller
+void Cartridge::load(std::shared_ptr<const ROMImage> image) {
+    ROM = std::move(image);
+    RAM.assign(getRAMSize(header.RAMSize), 0);
+
+    rombank.count = ROM ? ROM->size() / ROM_BANK_SIZE : 0;
+    rambank.count = RAM.size() / RAM_BANK_SIZE;
+
+    mapper = MBC::create(*this);
+}
+
+// Bank numbers past the end of the ROM wrap around like the unused bank bits do on hardware
+const uint8_t * Cartridge::getROMBank(unsigned int bank) const {
+    if (rombank.count == 0) {
+        return nullptr;
+    }
+    return ROM->data() + (bank % rombank.count) * ROM_BANK_SIZE;
+}
+
+uint8_t * Cartridge::getRAMBank(unsigned int bank) {
+    if (rambank.count == 0) {
+        return nullptr;
+    }
+    return RAM.data() + (bank % rambank.count) * RAM_BANK_SIZE;
+}
+
+// Cartridges with 2K of RAM still get a full 8K bank so the external RAM window can be mapped directly
+size_t Cartridge::getRAMSize(uint8_t code) {
+    switch (code) {
+        case 0x01:
+        case 0x02:
+            return RAM_BANK_SIZE;
+        case 0x03:
+            return 4 * RAM_BANK_SIZE;
+        case 0x04:
+            return 16 * RAM_BANK_SIZE;
+        case 0x05:
+            return 8 * RAM_BANK_SIZE;
+        default:
+            return 0;
+    }
+}
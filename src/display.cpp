@@ -1,19 +1,155 @@
 #include "display.hpp"
 #include "interrupts.hpp"
+#include "memory-bus.hpp"
+#include "render-worker.hpp"
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Spreads the 8 bits of a tile row byte into 8 bytes of 0 or 1, bit 7 (leftmost pixel) first.
+    // A 2K table, where a 64K table of decoded rows would spend half a megabyte of cache.
+    const std::array<uint64_t, 256> TILE_ROW_SPREAD = []() {
+        std::array<uint64_t, 256> table;
+        for (int byte = 0; byte < 256; byte++) {
+            uint8_t bits[8];
+            for (int i = 0; i < 8; i++) {
+                bits[i] = (byte >> (7 - i)) & 0x01;
+            }
+            std::memcpy(&table[byte], bits, 8);
+        }
+        return table;
+    }();
+
+    // LY and STAT are caught up to the current cycle before being read
+    uint8_t readLY(void * context, const uint16_t /*address*/) {
+        Display * display = static_cast<Display *>(context);
+        display->sync();
+        return display->LY;
+    }
+
+    uint8_t readSTAT(void * context, const uint16_t /*address*/) {
+        Display * display = static_cast<Display *>(context);
+        display->sync();
+        return display->LCDCSTAT;
+    }
+
+    // Writes that can move the next mode transition catch up first and then reschedule it
+    void writeLY(void * context, const uint16_t /*address*/, const uint8_t byte) {
+        Display * display = static_cast<Display *>(context);
+        display->sync();
+        display->LY = byte;
+        display->schedule();
+    }
+
+    void writeSTAT(void * context, const uint16_t /*address*/, const uint8_t byte) {
+        Display * display = static_cast<Display *>(context);
+        display->sync();
+        display->LCDCSTAT = byte;
+        display->schedule();
+    }
+}
 
 Display::Display() {
     cycles = 0;
     LX = 0;
     LY = 0;
+    LCDC = 0;
+    LCDCSTAT = 0x02;  // Start of a line, OAM search
+    LYC = 0;
+    VRAMEnable = true;
+    windowLine = 0;
+    spriteCount = 0;
+    tileDirty.fill(true);
+    tileReads.fill(0);
+    mapRowReads.fill(0);
+    spriteReads.fill(0);
+    visibleSprites.fill(-1);
+    OAM.fill(0);
+    indexSprites();
+    layerCache = false;
+    layerTileMode.fill(0);
+    deferred = false;
+    renderEnabled = true;
+    frameSkip = 1;
+    framesSkipped = 0;
+    frameRequested = false;
+    for (auto& frame : frameBuffers) {
+        for (auto& line : frame) {
+            line.fill(0);
+        }
+    }
+    frameSequences.fill(0);
+    frameNumber = 1;
+    backBuffer = 0;
+    readyBuffer = 1;
+    frontBuffer = 2;
+    pendingStart = 0;
+    pendingEnd = 0;
+    scheduler = nullptr;
+    synced = 0;
 }
 
 Display::~Display() {
+    worker.reset();  // Finishes any queued lines before the rest of the display goes away
+}
+
+// Connects the LCD registers to the memory bus
+void Display::registerIO(MemoryBus& memoryBus) {
+    memoryBus.registerIO(0xFF40, &LCDC);
+    memoryBus.registerIO(0xFF41, readSTAT, writeSTAT, this);
+    memoryBus.registerIO(0xFF42, &SCY);
+    memoryBus.registerIO(0xFF43, &SCX);
+    memoryBus.registerIO(0xFF44, readLY, writeLY, this);
+    memoryBus.registerIO(0xFF45, &LYC);
+    memoryBus.registerIO(0xFF46, &DMA);
+    memoryBus.registerIO(0xFF47, &BGP);
+    memoryBus.registerIO(0xFF48, &OBP0);
+    memoryBus.registerIO(0xFF49, &OBP1);
+    memoryBus.registerIO(0xFF4A, &WY);
+    memoryBus.registerIO(0xFF4B, &WX);
+}
+
+// Takes the display's timing from the scheduler, it only does work at its own mode transitions
+void Display::loadScheduler(Scheduler * scheduler) {
+    this->scheduler = scheduler;
+    synced = scheduler->now();
+    schedule();
+}
+
+// Catches the display up to the scheduler's current cycle
+void Display::sync() {
+    if (scheduler && scheduler->now() > synced) {
+        clock(scheduler->now() - synced);
+        synced = scheduler->now();
+    }
+}
 
+// Registers the next mode transition with the scheduler
+void Display::schedule() {
+    if (scheduler) {
+        scheduler->schedule(Event::PPU, synced + cyclesUntilModeChange());
+    }
 }
 
 void Display::clock() {
     cycles++;
+    update();
+}
+
+// Catches the PPU up by a number of T-cycles, jumping straight from one mode transition to the next
+void Display::clock(unsigned int count) {
+    while (count > 0) {
+        unsigned int step = std::min(count, cyclesUntilModeChange());
+        cycles += step;
+        count -= step;
+        update();
+    }
+}
 
+// Mode state machine, only acts once `cycles` reaches the end of the current mode
+void Display::update() {
     switch (LCDCSTAT & 0x03) {
         case 0x00:  // HBlank
             OAMAccess = true;
@@ -26,6 +162,8 @@ void Display::clock() {
                     // TODO: interrupt stuff
                 }
                 if (LY == 144) {
+                    renderPending();
+                    finishFrame();
                     setVBlankInterrupt();
                     // TODO: interrupt stuff
                     LCDCSTAT |= 0x01;
@@ -49,6 +187,10 @@ void Display::clock() {
             if (cycles >= 4560) {
                 cycles = 0;
                 LY = 0;
+                windowLine = 0;
+                pendingStart = 0;
+                pendingEnd = 0;
+                startFrame();
                 if (LYC == LY) {
                     setLYCInterrupt();
                     // TODO: interrupt stuff
@@ -72,7 +214,16 @@ void Display::clock() {
             OAMAccess = false;
             if (cycles >= 172) {
                 if ((LCDC & (1 << 7)) >> 7 == 1) {
-                    drawScanline();
+                    if (deferred) {
+                        lineLog[LY] = captureLine();
+                        pendingEnd = LY + 1;
+                    }
+                    else if (renderEnabled) {
+                        submitLine(captureLine());
+                    }
+                    else {
+                        captureLine();  // Still keeps the window line counter going
+                    }
                 }
                 LCDCSTAT &= 0xFC;
                 cycles = 0;
@@ -82,113 +233,508 @@ void Display::clock() {
     }
 }
 
+// Number of T-cycles until the next mode transition, used to bound how far the CPU runs ahead
+unsigned int Display::cyclesUntilModeChange() const {
+    switch (LCDCSTAT & 0x03) {
+        case 0x00:
+            return cycles < 204 ? 204 - cycles : 1;
+        case 0x01:
+            return 456 - (cycles % 456);
+        case 0x02:
+            return cycles < 80 ? 80 - cycles : 1;
+        default:
+            return cycles < 172 ? 172 - cycles : 1;
+    }
+}
+
+// Selects the first 10 sprites in OAM that overlap the current line
 void Display::spriteSelect() {
-    for (int item : visibleSprites) {
-        item = -1;  // reset sprites
+    uint64_t sprites = (LCDC & 0x04) ? tallSpriteLines[LY] : spriteLines[LY];
+
+    visibleSprites.fill(-1);
+    spriteCount = 0;
+
+    // Bits are in OAM order, so the lowest 10 set bits are the sprites the hardware picks.
+    // Kept sorted by priority, lower X first and OAM order among equal X.
+    while (sprites && spriteCount < 10) {
+        int sprite = __builtin_ctzll(sprites) * 4;
+        sprites &= sprites - 1;
+
+        unsigned int i = spriteCount++;
+        for (; i > 0 && OAM[visibleSprites[i - 1] + 1] > OAM[sprite + 1]; i--) {
+            visibleSprites[i] = visibleSprites[i - 1];
+        }
+        visibleSprites[i] = sprite;
+    }
+}
+
+// Moves a sprite between the per-line sprite masks when its Y coordinate changes
+void Display::indexSprite(unsigned int sprite, uint8_t oldY, uint8_t newY) {
+    uint64_t bit = uint64_t(1) << sprite;
+
+    for (int line = std::max(oldY - 16, 0); line < std::min<int>(oldY, 144); line++) {
+        tallSpriteLines[line] &= ~bit;
+        spriteLines[line] &= ~bit;
     }
 
-    int index = 0;
+    for (int line = std::max(newY - 16, 0); line < std::min<int>(newY, 144); line++) {
+        tallSpriteLines[line] |= bit;
+        if (line < newY - 8) {
+            spriteLines[line] |= bit;
+        }
+    }
+}
 
-    for (int i = 0; i < 0xA0; i += 4) {
-        if (index < 10) {
-            int y = OAM[i];
-            if (y > 0 && y < 160) {
-                if (y - 8 >= LY && y - 16 <= LY) {
-                    int x = OAM[i + 1];
-                    if (x > 0 && x < 168) {
-                        visibleSprites[index] = i;
-                    }
-                    else {
-                        visibleSprites[index] = -1;  // not drawn
-                    }
-                    index++;
-                }
+// Rebuilds the per-line sprite masks, needed after OAM is changed without going through writeOAM
+void Display::indexSprites() {
+    spriteLines.fill(0);
+    tallSpriteLines.fill(0);
+
+    for (unsigned int i = 0; i < 40; i++) {
+        indexSprite(i, 0, OAM[i * 4]);
+    }
+}
+
+// Copies the registers the renderer needs for the current line
+Display::LineState Display::captureLine() {
+    LineState line;
+    line.LY = LY;
+    line.LCDC = LCDC;
+    line.SCX = SCX;
+    line.SCY = SCY;
+    line.WX = WX;
+    line.BGP = BGP;
+    line.OBP0 = OBP0;
+    line.OBP1 = OBP1;
+
+    // The window keeps its own line counter, it only advances on lines the window is visible
+    line.windowVisible = (LCDC & 0x01) && windowEnable() && LY >= WY && WX <= 166;
+    line.windowLine = windowLine;
+    if (line.windowVisible) {
+        windowLine++;
+    }
+
+    line.spriteCount = spriteCount;
+    for (unsigned int i = 0; i < spriteCount; i++) {
+        line.sprites[i] = visibleSprites[i];
+    }
+
+    return line;
+}
+
+void Display::drawScanline(const LineState& state) {
+    std::array<uint8_t, 160> line;  // Background and window colour indices, before the palette
+
+    if (state.LCDC & 0x01) {
+        drawBackground(state, line);
+        drawWindow(state, line);
+    }
+    else {
+        line.fill(0);  // Background and window disabled, sprites always win over it
+    }
+
+    // A disabled background is white (shade 0) whatever BGP maps colour 0 to
+    std::array<uint8_t, 4> palette = (state.LCDC & 0x01) ? getPalette(state.BGP) : std::array<uint8_t, 4>{};
+    FrameBuffer::value_type& pixels = frameBuffers[backBuffer][state.LY];
+
+    std::array<uint8_t, 160> sprites;
+    if (!drawSprites(state, sprites)) {
+        for (int x = 0; x < 160; x++) {
+            pixels[x] = palette[line[x]];
+        }
+        return;
+    }
+
+    for (int x = 0; x < 160; x++) {
+        // A winning sprite behind background colours 1-3 hides lower priority sprites as well
+        bool sprite = (sprites[x] & 0x04) && !((sprites[x] & 0x80) && line[x] != 0);
+        pixels[x] = sprite ? (sprites[x] & 0x03) : palette[line[x]];
+    }
+}
+
+void Display::drawBackground(const LineState& state, std::array<uint8_t, 160>& line) {
+    uint8_t y = state.SCY + state.LY;
+
+    if (layerCache) {
+        // Layer rows carry a copy of their start past the end, so wrapping around is still one copy
+        const uint8_t * layer = getLayerRow((state.LCDC & 0x08) ? 1 : 0, state.LCDC, y);
+        std::memcpy(line.data(), layer + state.SCX, 160);
+        return;
+    }
+
+    uint16_t mapRow = ((state.LCDC & 0x08) ? 0x1C00 : 0x1800) + (y / 8) * 32;
+    unsigned int row = y % 8;
+    unsigned int firstTile = state.SCX / 8;
+
+    // 21 tiles cover the line for any fine scroll, the map wraps around after 32 tiles
+    std::array<uint8_t, 168> pixels;
+
+    for (unsigned int i = 0; i < 21; i++) {
+        unsigned int tile = getTileIndex(state.LCDC, VRAM[mapRow + ((firstTile + i) & 31)]);
+        std::memcpy(&pixels[i * 8], getTileRow(tile, row), 8);
+    }
+
+    std::memcpy(line.data(), &pixels[state.SCX % 8], 160);
+}
+
+void Display::drawWindow(const LineState& state, std::array<uint8_t, 160>& line) {
+    if (!state.windowVisible) {
+        return;
+    }
+
+    int left = state.WX - 7;  // Can be negative, the window then starts partly off screen
+
+    if (layerCache) {
+        int start = std::max(left, 0);
+        const uint8_t * layer = getLayerRow((state.LCDC & 0x40) ? 1 : 0, state.LCDC, state.windowLine);
+        std::memcpy(line.data() + start, layer + (start - left), 160 - start);
+        return;
+    }
+
+    uint16_t mapRow = ((state.LCDC & 0x40) ? 0x1C00 : 0x1800) + (state.windowLine / 8) * 32;
+    unsigned int row = state.windowLine % 8;
+
+    std::array<uint8_t, 168> pixels;
+
+    for (unsigned int i = 0; i < 21; i++) {
+        std::memcpy(&pixels[i * 8], getTileRow(getTileIndex(state.LCDC, VRAM[mapRow + i]), row), 8);
+    }
+
+    for (int x = std::max(left, 0); x < 160; x++) {
+        line[x] = pixels[x - left];
+    }
+}
+
+// Resolves the sprite pixels of a line, returns false if there are none
+bool Display::drawSprites(const LineState& state, std::array<uint8_t, 160>& sprites) {
+    if (!(state.LCDC & 0x02) || state.spriteCount == 0) {
+        return false;
+    }
+
+    int height = (state.LCDC & 0x04) ? 16 : 8;
+
+    // Sprites come in priority order so the first opaque pixel in a column wins.
+    // Shade in bits 0-1, bit 2 marks a sprite pixel, bit 7 that it is behind the background.
+    sprites.fill(0);
+
+    std::array<uint8_t, 4> palettes[2] = {getPalette(state.OBP0), getPalette(state.OBP1)};
+
+    for (unsigned int i = 0; i < state.spriteCount; i++) {
+        const uint8_t * entry = &OAM[state.sprites[i]];
+        int x = entry[1] - 8;
+        uint8_t tileNumber = entry[2];
+        uint8_t attr = entry[3];
+
+        int row = state.LY - (entry[0] - 16);
+        if (attr & 0x40) {  // Y flip
+            row = height - 1 - row;
+        }
+        if (height == 16) {
+            tileNumber &= 0xFE;
+        }
+
+        // Sprites always use unsigned tiles from 0x8000, 8x16 sprites run into the next tile
+        uint8_t pixels[8];
+        std::memcpy(pixels, getTileRow(tileNumber + row / 8, row % 8), 8);
+        if (attr & 0x20) {  // X flip
+            std::reverse(pixels, pixels + 8);
+        }
+
+        const std::array<uint8_t, 4>& palette = palettes[spritePalette(attr)];
+        uint8_t flags = 0x04 | (attr & 0x80);
+
+        for (int px = std::max(-x, 0); px < std::min(160 - x, 8); px++) {
+            if (pixels[px] != 0 && sprites[x + px] == 0) {
+                sprites[x + px] = palette[pixels[px]] | flags;
             }
         }
     }
+
+    return true;
 }
 
-void Display::drawScanline() {
-    int offsetY = (int) (((float) LY + (float) SCY) / 8);
-    int offsetX = (int) (((float) SCX + (float) LX) / 8);
-    uint16_t tileOffset = ((SCY + LY) % 8) * 2;
-    uint16_t startAddress = getBackgroundMapAddress() + (offsetY * 32) + offsetX;
-    uint16_t windowStartAddress = getWindowMapAddress() + (WY * 4) + WX;
+// Draws a line here or hands it to the render thread
+void Display::submitLine(const LineState& line) {
+    if (worker) {
+        recordReads(line, worker->push(line));
+    }
+    else {
+        drawScanline(line);
+    }
+}
+
+// Notes which tiles, map rows and OAM entries a queued line reads, the same ones drawScanline() does
+void Display::recordReads(const LineState& line, size_t ticket) {
+    if (layerCache) {
+        return;  // Writes wait for the whole queue, the layers are shared by all lines
+    }
+
+    if (line.LCDC & 0x01) {
+        recordMapRow((line.LCDC & 0x08) ? 1 : 0, (uint8_t) (line.SCY + line.LY) / 8, line.SCX / 8, line.LCDC, ticket);
+        if (line.windowVisible) {
+            recordMapRow((line.LCDC & 0x40) ? 1 : 0, line.windowLine / 8, 0, line.LCDC, ticket);
+        }
+    }
 
-    for (int i = 0; i < 20; i++) {
-        uint16_t start = (getBackgroundStartAddress() + VRAM[(windowStartAddress + i - 0x8000) & 0x1FFF] * 16) - 0x8000;
-        if (LY >= WY && LX >= WX - 7 && windowEnable()) {
-            tileOffset = (LY % 8) * 2;
-            if (getBackgroundStartAddress() == 0x8000) {
-                drawBackgroundLine(VRAM[start + tileOffset], VRAM[start + tileOffset + 1]);
+    if (line.LCDC & 0x02) {
+        for (unsigned int i = 0; i < line.spriteCount; i++) {
+            uint8_t tileNumber = OAM[line.sprites[i] + 2];
+            spriteReads[line.sprites[i] / 4] = ticket;
+
+            if (line.LCDC & 0x04) {
+                tileReads[tileNumber & 0xFE] = ticket;
+                tileReads[tileNumber | 0x01] = ticket;
             }
             else {
-                uint8_t tileNumber = VRAM[(windowStartAddress + i - 0x8000) & 0x1FFF];
-                if (tileNumber <= 127) {
-                    start = (getBackgroundStartAddress() + VRAM[(windowStartAddress + i - 0x8000) & 0x1FFF] * 16) - 0x8000;
-                }
-                else {
-                    start = tileNumber * 16;
-                }
-                drawBackgroundLine(VRAM[start + tileOffset], VRAM[start + tileOffset + 1]);
+                tileReads[tileNumber] = ticket;
             }
         }
+    }
+}
+
+// A line reads 21 cells of a map row from the first one on, wrapping around
+void Display::recordMapRow(unsigned int map, unsigned int row, unsigned int first, uint8_t lcdc, size_t ticket) {
+    const uint8_t * cells = &VRAM[0x1800 + map * 0x400 + row * 32];
+
+    mapRowReads[map * 32 + row] = ticket;
+    for (unsigned int i = 0; i < 21; i++) {
+        tileReads[getTileIndex(lcdc, cells[(first + i) % 32])] = ticket;
+    }
+}
+
+// Renders every line logged since the last call, or drops them if nobody wants this frame
+void Display::renderPending() {
+    if (renderEnabled) {
+        for (unsigned int i = pendingStart; i < pendingEnd; i++) {
+            submitLine(lineLog[i]);
+        }
+    }
+    pendingStart = pendingEnd;
+}
+
+// Deferred rendering logs each line's registers and draws the whole frame at VBlank
+void Display::setDeferredRendering(bool enable) {
+    renderPending();
+    deferred = enable;
+}
+
+// Draws lines on a separate thread, the output is identical to drawing them inline
+void Display::setThreadedRendering(bool enable) {
+    if (enable && !worker) {
+        tileReads.fill(0);  // Tickets start over with each worker
+        mapRowReads.fill(0);
+        spriteReads.fill(0);
+        worker = std::make_unique<RenderWorker>(*this);
+    }
+    else if (!enable) {
+        worker.reset();
+    }
+}
+
+// Draws every interval-th frame and only runs the timing for the others, 0 draws only requested frames
+void Display::setFrameSkip(unsigned int interval) {
+    frameSkip = interval;
+    framesSkipped = interval;  // Draw the next frame, then start skipping
+}
+
+// Draws the next frame regardless of the frame skip
+void Display::requestFrame() {
+    frameRequested = true;
+}
+
+// Decides at the start of a frame whether its lines get drawn
+void Display::startFrame() {
+    frameNumber++;
+
+    if (frameRequested || (frameSkip != 0 && framesSkipped + 1 >= frameSkip)) {
+        renderEnabled = true;
+        frameRequested = false;
+        framesSkipped = 0;
+    }
+    else {
+        renderEnabled = false;
+        framesSkipped++;
+    }
+}
+
+// Decodes one 2bpp tile row into 8 colour indices, leftmost pixel first
+void Display::decodeTileRow(uint8_t low, uint8_t high, uint8_t * pixels) {
+    uint64_t row = TILE_ROW_SPREAD[low] | (TILE_ROW_SPREAD[high] << 1);
+    std::memcpy(pixels, &row, 8);
+}
+
+// Index into the tile cache of a background/window tile, signed tile numbers are relative to 0x9000
+unsigned int Display::getTileIndex(uint8_t lcdc, uint8_t tileNumber) {
+    if (lcdc & 0x10) {
+        return tileNumber;
+    }
+    else {
+        return 256 + (int8_t) tileNumber;
+    }
+}
+
+void Display::writeVRAM(const uint16_t offset, const uint8_t byte) {
+    if (pendingStart != pendingEnd) {
+        renderPending();  // Logged lines have to be drawn with the VRAM they saw
+    }
+    if (worker) {
+        if (layerCache) {
+            worker->wait();
+        }
+        else if (offset < TILE_COUNT * 16) {
+            worker->waitFor(tileReads[offset / 16]);
+        }
         else {
-            start = (getBackgroundStartAddress() + VRAM[(startAddress + i - 0x8000) & 0x1FFF] * 16) - 0x8000;
-            if (getBackgroundStartAddress() == 0x8000) {
-                drawBackgroundLine(VRAM[start + tileOffset], VRAM[start + tileOffset + 1]);
-            }
-            else {
-                uint8_t tileNumber = VRAM[(startAddress + i - 0x8000) & 0x1FFF];
-                if (tileNumber <= 127) {
-                    start = (getBackgroundStartAddress() + VRAM[(startAddress + i - 0x8000) & 0x1FFF] * 16) - 0x8000;
-                }
-                else {
-                    start = tileNumber * 16;
-                }
-                drawBackgroundLine(VRAM[start + tileOffset], VRAM[start + tileOffset + 1]);
-            }
+            worker->waitFor(mapRowReads[(offset - 0x1800) / 32]);
+        }
+    }
+
+    VRAM[offset] = byte;
+
+    if (offset < TILE_COUNT * 16) {
+        tileDirty[offset / 16] = true;
+        if (layerCache) {
+            tileChanged[offset / 16] = true;
+            tilesChanged = true;
+        }
+    }
+    else if (layerCache) {
+        cellDirty[(offset - 0x1800) / 0x400][offset % 0x400] = true;
+        rowDirty[(offset - 0x1800) / 0x400][(offset % 0x400) / 32] = true;
+    }
+}
+
+// Keeps fully drawn 256x256 background layers of both tile maps and copies lines out of them,
+// instead of fetching the tiles of every line. Only the 8x8 cells touched by VRAM writes are redrawn.
+void Display::setLayerCache(bool enable) {
+    if (worker) {
+        worker->wait();
+    }
+
+    layerCache = enable;
+
+    if (enable) {
+        layers.resize(2 * 256 * LAYER_STRIDE);
+        for (auto& cells : cellDirty) {
+            cells.fill(true);
         }
+        for (auto& rows : rowDirty) {
+            rows.fill(true);
+        }
+        tileChanged.fill(false);
+        tilesChanged = false;
+    }
+    else {
+        layers = std::vector<uint8_t>();
+    }
+}
+
+// Row y of a cached layer, redrawing the dirty cells of its row of tiles first
+const uint8_t * Display::getLayerRow(unsigned int map, uint8_t lcdc, uint8_t y) {
+    if (layerTileMode[map] != (lcdc & 0x10)) {
+        layerTileMode[map] = lcdc & 0x10;  // Tile numbers now refer to other tiles
+        cellDirty[map].fill(true);
+        rowDirty[map].fill(true);
+    }
 
-        for (int j = 0; j < 10; j++) {
-            if ((LCDC & (1 << 1)) >> 1 == 0x1 && visibleSprites[j] >= 0) {
-                if (OAM[visibleSprites[j] + 1] - 8 >= LX && OAM[visibleSprites[j] + 1] <= LX + 8) {
-                    start = OAM[visibleSprites[j] + 2] * 16;
-                    tileOffset = (LY % 8) * 2;
-                    drawSpriteLine((OAM[visibleSprites[j] + 3] & (1 << 4)) >> 4, VRAM[start + tileOffset], VRAM[start + tileOffset + 1]);
+    if (tilesChanged) {
+        // Tile data was written, find the cells of both maps showing those tiles
+        for (unsigned int m = 0; m < 2; m++) {
+            for (unsigned int cell = 0; cell < 0x400; cell++) {
+                if (tileChanged[getTileIndex(layerTileMode[m], VRAM[0x1800 + m * 0x400 + cell])]) {
+                    cellDirty[m][cell] = true;
+                    rowDirty[m][cell / 32] = true;
                 }
             }
         }
+        tileChanged.fill(false);
+        tilesChanged = false;
+    }
+
+    uint8_t * layer = &layers[map * 256 * LAYER_STRIDE];
+
+    if (!rowDirty[map][y / 8]) {
+        return layer + y * LAYER_STRIDE;
     }
-}
 
-void Display::drawSpriteLine(uint8_t attr, uint8_t left, uint8_t right) {
-    for (int i = 0; i < 8; i++) {
-        uint8_t selection = ((((1 << (7 - i)) & left)) >> (7 - i)) << 1 | ((1 << (7 - i)) & right) >> (7 - i);
-        uint8_t color = 0;
-        if (spritePalette(attr) == 1) {
-            color = (OBP1 & (0x03 << (selection * 2))) >> (selection * 2);
+    // Redraws the whole row of cells, not just the visible ones, so the row is clean afterwards
+    unsigned int firstCell = (y / 8u) * 32;
+    for (unsigned int cell = firstCell; cell < firstCell + 32; cell++) {
+        if (!cellDirty[map][cell]) {
+            continue;
         }
-        else {
-            color = (OBP0 & (0x03 << (selection * 2))) >> (selection * 2);
+
+        unsigned int tile = getTileIndex(layerTileMode[map], VRAM[0x1800 + map * 0x400 + cell]);
+        uint8_t * pixels = layer + (cell / 32) * 8 * LAYER_STRIDE + (cell % 32) * 8;
+        for (unsigned int row = 0; row < 8; row++) {
+            std::memcpy(pixels + row * LAYER_STRIDE, getTileRow(tile, row), 8);
+            if (cell % 32 < 20) {
+                std::memcpy(pixels + row * LAYER_STRIDE + 256, getTileRow(tile, row), 8);
+            }
         }
+        cellDirty[map][cell] = false;
+    }
+    rowDirty[map][y / 8] = false;
+
+    return layer + y * LAYER_STRIDE;
+}
 
-        if (color != 0) {
-            frameBuffer[LY][LX + i] = color;
+void Display::writeOAM(const uint16_t offset, const uint8_t byte) {
+    if (pendingStart != pendingEnd) {
+        renderPending();
+    }
+    if (worker) {
+        worker->waitFor(spriteReads[offset / 4]);
+    }
+
+    if (offset % 4 == 0 && OAM[offset] != byte) {
+        indexSprite(offset / 4, OAM[offset], byte);
+    }
+
+    OAM[offset] = byte;
+}
+
+// Decoded pixels of one row of a tile, decoding the whole tile first if it changed since last use
+const uint8_t * Display::getTileRow(unsigned int tile, unsigned int row) {
+    if (tileDirty[tile]) {
+        for (unsigned int i = 0; i < 8; i++) {
+            decodeTileRow(VRAM[tile * 16 + i * 2], VRAM[tile * 16 + i * 2 + 1], &tiles[tile][i * 8]);
         }
+        tileDirty[tile] = false;
     }
+
+    return &tiles[tile][row * 8];
 }
 
-void Display::drawBackgroundLine(uint8_t left, uint8_t right) {
-    for (int i = 0; i < 8; i++) {
-        uint8_t selection = ((((1 << (7 - i)) & left)) >> (7 - i)) << 1 | ((1 << (7 - i)) & right) >> (7 - i);
-        uint8_t color = (BGP & (0x03 << (selection * 2))) >> (selection * 2);
-        frameBuffer[LY][LX + i] = color;
+// Needed after VRAM is changed without going through writeVRAM, redraws the cached layers as well
+void Display::invalidateTiles() {
+    if (worker) {
+        worker->wait();
     }
+    tileDirty.fill(true);
+
+    if (layerCache) {
+        for (auto& cells : cellDirty) {
+            cells.fill(true);
+        }
+        for (auto& rows : rowDirty) {
+            rows.fill(true);
+        }
+    }
+}
+
+// Shade for each of the 4 colour indices
+std::array<uint8_t, 4> Display::getPalette(uint8_t palette) {
+    return {
+        (uint8_t) (palette & 0x03),
+        (uint8_t) ((palette >> 2) & 0x03),
+        (uint8_t) ((palette >> 4) & 0x03),
+        (uint8_t) ((palette >> 6) & 0x03)
+    };
 }
 
 uint16_t Display::getBackgroundStartAddress() {
-    if (LCDC & 0x10 >> 4 == 1) {
+    if (LCDC & 0x10) {
         return 0x8000;
     }
     else {
@@ -197,7 +743,7 @@ uint16_t Display::getBackgroundStartAddress() {
 }
 
 uint16_t Display::getBackgroundMapAddress() {
-    if (LCDC & 0x08 >> 3 == 1) {
+    if (LCDC & 0x08) {
         return 0x9C00;
     }
     else {
@@ -206,7 +752,7 @@ uint16_t Display::getBackgroundMapAddress() {
 }
 
 uint16_t Display::getWindowMapAddress() {
-    if (LCDC & 0x40 >> 6 == 1) {
+    if (LCDC & 0x40) {
         return 0x9C00;
     }
     else {
@@ -238,6 +784,37 @@ bool Display::windowEnable() {
     return ((LCDC & (1 << 5)) >> 5) == 1;
 }
 
-std::array<std::array<uint8_t, 160>, 144> Display::getFrameBuffer() {
-    return frameBuffer;
+// Publishes the frame drawn into the back buffer, with threaded rendering once the worker has drawn it
+void Display::finishFrame() {
+    if (!renderEnabled || !(LCDC & 0x80)) {
+        return;  // Nothing was drawn this frame, the last completed frame stays current
+    }
+
+    if (worker) {
+        worker->publish(frameNumber);
+    }
+    else {
+        publishFrame(frameNumber);
+    }
+}
+
+// Makes the back buffer the latest completed frame and takes over the old one
+void Display::publishFrame(uint64_t sequence) {
+    frameSequences[backBuffer] = sequence;
+    backBuffer = readyBuffer.exchange(backBuffer | FRESH_FRAME, std::memory_order_acq_rel) & 0x03;
+}
+
+// Latest completed frame. The pixels stay untouched until the next call, which may come from another
+// thread than the emulation, but only one consumer may acquire frames.
+Display::Frame Display::acquireFrame() {
+    if (readyBuffer.load(std::memory_order_relaxed) & FRESH_FRAME) {
+        frontBuffer = readyBuffer.exchange(frontBuffer, std::memory_order_acq_rel) & 0x03;
+    }
+
+    return {&frameBuffers[frontBuffer], frameSequences[frontBuffer]};
+}
+
+// Whether a completed frame is waiting that the consumer has not acquired yet
+bool Display::isFramePending() const {
+    return readyBuffer.load(std::memory_order_relaxed) & FRESH_FRAME;
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "emulation-thread.hpp"
+
+#include "motherboard.hpp"
+
+namespace {
+	using namespace std::chrono_literals;
+
+	// Long enough that timestamp jitter can't hide the 0.1% between 60 and 59.94 Hz
+	const FramePacer::Clock::duration MEASURE_TIME = 5s;
+	// A longer swap means the UI thread was held up, the measurement starts over
+	const FramePacer::Clock::duration MAX_SWAP_INTERVAL = 50ms;
+}
+
+EmulationThread::EmulationThread(Motherboard& motherboard)
+		: motherboard(motherboard)
+		, running(false)
+		, speed(1)
+		, measuredSwaps(0)
+		, measuring(false)
+		, refreshRate(0) {}
+
+// Rate the display reports, used until presented() has measured the real one. Only takes
+// effect before start(), see FramePacer::matchRefreshRate()
+void EmulationThread::setRefreshRate(double refreshRate) {
+	pacer.matchRefreshRate(refreshRate);
+}
+
+// Called by the UI thread after every buffer swap. With vsync the swaps follow the display, so
+// their measured rate corrects the pacer for drift between the emulation and the display, such
+// as a 59.94 Hz panel that the driver reports as 60 Hz. Without vsync the measured rate is far
+// off and the pacer falls back to the Game Boy's own rate.
+void EmulationThread::presented() {
+	FramePacer::Clock::time_point now = FramePacer::Clock::now();
+	FramePacer::Clock::time_point previous = lastSwap;
+	lastSwap = now;
+
+	if (!measuring || now - previous > MAX_SWAP_INTERVAL) {
+		measureStart = now;
+		measuredSwaps = 0;
+		measuring = true;
+		return;
+	}
+
+	measuredSwaps++;
+
+	if (now - measureStart >= MEASURE_TIME) {
+		refreshRate.store(measuredSwaps / std::chrono::duration<double>(now - measureStart).count(), std::memory_order_relaxed);
+		measureStart = now;
+		measuredSwaps = 0;
+	}
+}
+
+// Multiple of the normal speed, 0 runs as fast as possible. Above normal speed only frames the
+// UI thread is going to show get drawn, the others just run their timing.
+void EmulationThread::setSpeed(unsigned int speed) {
+	this->speed.store(speed, std::memory_order_relaxed);
+}
+
+void EmulationThread::start() {
+	if (!running.exchange(true)) {
+		pacer.reset();
+		thread = std::thread(&EmulationThread::run, this);
+	}
+}
+
+void EmulationThread::stop() {
+	if (running.exchange(false)) {
+		thread.join();
+	}
+}
+
+InputQueue& EmulationThread::getInput() {
+	return input;
+}
+
+void EmulationThread::run() {
+	InputEvent event;
+	unsigned int currentSpeed = 1;
+	double currentRefreshRate = 0;
+
+	while (running.load(std::memory_order_relaxed)) {
+		unsigned int speed = this->speed.load(std::memory_order_relaxed);
+
+		if (speed != currentSpeed) {
+			pacer.setSpeed(speed);
+			motherboard.setFrameSkip(speed == 1 ? 1 : 0);
+			currentSpeed = speed;
+		}
+
+		double refreshRate = this->refreshRate.load(std::memory_order_relaxed);
+		if (refreshRate != currentRefreshRate) {
+			pacer.matchRefreshRate(refreshRate);
+			currentRefreshRate = refreshRate;
+		}
+
+		// Fast forwarding draws a frame only once the previous one was picked up, which keeps
+		// drawing at the presentation rate however fast emulation runs
+		if (speed != 1 && !motherboard.isFramePending()) {
+			motherboard.requestFrame();
+		}
+
+		// Input is applied on frame boundaries, the game polls it at most once a frame anyway
+		while (input.pop(event)) {
+			motherboard.setButton(event.button, event.pressed);
+		}
+
+		motherboard.runFrame();
+
+		pacer.wait();
+	}
+}
+
+EmulationThread::~EmulationThread() {
+	stop();
+}
@@ -0,0 +1,94 @@
+#include "frame-pacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+	using namespace std::chrono_literals;
+
+	const FramePacer::Clock::duration MIN_MARGIN = 200us;
+	const FramePacer::Clock::duration MAX_MARGIN = 4ms;
+	const FramePacer::Clock::duration MAX_LAG = 100ms;
+
+	// Refresh rates closer than this to the real frame rate are run at instead, 60 Hz is 0.46% off
+	const double MAX_RATE_ADJUST = 0.01;
+}
+
+FramePacer::FramePacer()
+		: deadline(Clock::now())
+		, margin(500us)
+		, speed(1) {
+	setRate(FRAME_RATE);
+}
+
+void FramePacer::setRate(double rate) {
+	this->rate = rate;
+	updatePeriod();
+}
+
+// Runs speed times faster than the rate, 0 does not wait at all
+void FramePacer::setSpeed(unsigned int speed) {
+	this->speed = speed;
+	updatePeriod();
+}
+
+void FramePacer::updatePeriod() {
+	if (speed != 0) {
+		period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / (rate * speed)));
+	}
+}
+
+// Runs at the display's refresh rate when it is close to the real one, so every frame is shown
+// exactly once instead of one being repeated or dropped every few seconds. The rate comes from
+// the swap intervals EmulationThread::presented() measures, before the first measurement from
+// the rounded rate the driver reports.
+void FramePacer::matchRefreshRate(double refreshRate) {
+	if (refreshRate > 0 && std::abs(refreshRate - FRAME_RATE) / FRAME_RATE < MAX_RATE_ADJUST) {
+		setRate(refreshRate);
+	}
+	else {
+		setRate(FRAME_RATE);
+	}
+}
+
+// Starts counting frames from now, for after the loop was paused
+void FramePacer::reset() {
+	deadline = Clock::now();
+}
+
+// Blocks until one period after the previous deadline
+void FramePacer::wait() {
+	Clock::time_point now = Clock::now();
+
+	if (speed == 0) {
+		deadline = now;  // Counts from here once a speed is set again
+		return;
+	}
+
+	deadline += period;
+
+	// After a stall (debugger, suspend, overloaded host) start over rather than racing to catch up
+	if (now - deadline > MAX_LAG) {
+		deadline = now;
+		return;
+	}
+
+	Clock::time_point wake = deadline - margin;
+
+	if (now < wake) {
+		std::this_thread::sleep_until(wake);
+
+		// Grow the margin as soon as a wake up comes late, shrink it slowly when they are punctual
+		Clock::duration target = std::clamp<Clock::duration>((Clock::now() - wake) * 2, MIN_MARGIN, MAX_MARGIN);
+		margin = target > margin ? target : margin - (margin - target) / 16;
+	}
+
+	while (Clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+}
+
+double FramePacer::getRate() const {
+	return rate;
+}
@@ -0,0 +1,159 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "motherboard.hpp"
+#include "palette.hpp"
+
+namespace {
+	// FNV-1a over the shade indices, so runs can be compared without keeping screenshots around
+	uint64_t hashFrame(const Display::FrameBuffer& frame) {
+		uint64_t hash = 0xCBF29CE484222325;
+
+		for (const auto& row : frame) {
+			for (uint8_t pixel : row) {
+				hash = (hash ^ pixel) * 0x100000001B3;
+			}
+		}
+
+		return hash;
+	}
+
+	bool writePPM(const std::string& filename, const Display::FrameBuffer& frame) {
+		std::vector<uint8_t> pixels(160 * 144 * 3);
+		Palette().convert(frame, pixels.data(), PixelFormat::RGB888);
+
+		FILE * file = fopen(filename.c_str(), "wb");
+		if (!file) {
+			return false;
+		}
+
+		fprintf(file, "P6\n160 144\n255\n");
+		fwrite(pixels.data(), 1, pixels.size(), file);
+		fclose(file);
+
+		return true;
+	}
+}
+
+// Runs a ROM without a window or audio device for a number of frames, or until the screen stops
+// changing, then prints the frame count, speed and a hash of the last frame. Exits with 2 when the
+// screen was still changing after the frame limit.
+int main(int argc, char** argv) {
+	std::string gameFilename;
+	std::string bootFilename;
+	std::string outputFilename;
+	unsigned int frameLimit = 0;
+	unsigned int staticFrames = 0;
+	bool layerCache = false;
+
+	cxxopts::Options options("GameBoyHeadless", "Runs a Game Boy ROM without display or audio");
+
+	try {
+		options.add_options()
+			("f,file", "ROM File name", cxxopts::value<std::string>())
+			("b,boot", "Boot ROM file name", cxxopts::value<std::string>()->default_value("../res/DMG_ROM.bin"))
+			("n,frames", "Number of frames to run, 0 for no limit", cxxopts::value<unsigned int>()->default_value("0"))
+			("until-static", "Stop once the screen did not change for this many frames", cxxopts::value<unsigned int>()->default_value("0"))
+			("o,output", "Write the last frame to a PPM file", cxxopts::value<std::string>())
+			("layer-cache", "Draw the background and window from cached tile map layers")
+			("h,help", "Help menu")
+			;
+
+		auto result = options.parse(argc, argv);
+
+		if (result.count("h")) {
+			std::cout << options.help({"", "Group"}) << std::endl;
+			return 0;
+		}
+
+		if (!result.count("f")) {
+			std::cerr << "No file specified! Exiting..." << std::endl;
+			return 1;
+		}
+
+		gameFilename = result["f"].as<std::string>();
+		bootFilename = result["b"].as<std::string>();
+		frameLimit = result["n"].as<unsigned int>();
+		staticFrames = result["until-static"].as<unsigned int>();
+		layerCache = result.count("layer-cache");
+
+		if (result.count("o")) {
+			outputFilename = result["o"].as<std::string>();
+		}
+	}
+	catch (const cxxopts::OptionException& e) {
+		std::cerr << "Error parsing options: " << e.what() << std::endl;
+		std::cout << options.help({"", "Group"}) << std::endl;
+		return 1;
+	}
+
+	if (frameLimit == 0 && staticFrames == 0) {
+		std::cerr << "Neither a frame limit nor a stop condition given! Exiting..." << std::endl;
+		return 1;
+	}
+
+	Motherboard motherboard;
+
+	if (!motherboard.loadCartridge(gameFilename) || !motherboard.loadBootROM(bootFilename)) {
+		return 1;
+	}
+	motherboard.setLayerCache(layerCache);
+
+	// Without a stop condition only the last frame is ever looked at, so only that one gets drawn
+	if (staticFrames == 0) {
+		motherboard.setFrameSkip(0);
+	}
+
+	Display::FrameBuffer previous = {};
+	unsigned int unchanged = 0;
+	unsigned int frames = 0;
+	bool stopped = false;
+
+	auto start = std::chrono::steady_clock::now();
+
+	while (frameLimit == 0 || frames < frameLimit) {
+		// The LCD's frames are out of phase with runFrame() once software turned it on, the last
+		// one completed can have started in the frame before
+		if (staticFrames == 0 && frames + 2 >= frameLimit) {
+			motherboard.requestFrame();
+		}
+
+		motherboard.runFrame();
+		frames++;
+
+		if (staticFrames != 0) {
+			const Display::FrameBuffer& frame = *motherboard.acquireFrame().pixels;
+
+			if (std::memcmp(&frame, &previous, sizeof(frame)) == 0) {
+				if (++unchanged >= staticFrames) {
+					stopped = true;
+					break;
+				}
+			}
+			else {
+				previous = frame;
+				unchanged = 0;
+			}
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const Display::FrameBuffer& frame = *motherboard.acquireFrame().pixels;
+
+	printf("%u frames in %.3f s (%.1f fps), frame hash %016llx\n", frames, seconds, frames / seconds,
+			(unsigned long long) hashFrame(frame));
+
+	if (!outputFilename.empty() && !writePPM(outputFilename, frame)) {
+		std::cerr << "Could not write output file: " << outputFilename << std::endl;
+		return 1;
+	}
+
+	return staticFrames != 0 && !stopped ? 2 : 0;
+}
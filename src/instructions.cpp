@@ -6,19 +6,13 @@
 #include <cstdio>
 
 Instructions::Instructions() {
+	prefixed.fill(nullptr);  // Unassigned opcodes are reported as invalid by the processor
+	nonPrefixed.fill(nullptr);
+
 	initPrefixed();
 	initNonPrefixed();
 }
 
-Instruction Instructions::fetchInstruction(const uint8_t instructionByte, bool prefixByte) {
-	if (prefixByte) {
-		return prefixed[instructionByte];
-	}
-	else {
-		return nonPrefixed[instructionByte];
-	}
-}
-
 Instructions::~Instructions() {
 
 }
@@ -3580,8 +3574,7 @@ namespace {
 	void op_JR(unsigned int& cycles, Registers& reg, MemoryBus& mem) {
 		cycles = 12;
 
-		int8_t offset = mem.read(reg.PC + 1) + 1;
-		reg.PC += (uint16_t) offset;
+		reg.PC += (int8_t) mem.read(reg.PC + 1);
 
 		reg.PC += 2;
 	}
@@ -3867,10 +3860,6 @@ namespace {
 	void op_EI(unsigned int& cycles, Registers& reg, MemoryBus& mem) {
 		cycles = 4;
 
-		// TODO: implement interrupts
-		std::cerr << "unsupported instruction 0xFB, exiting...";
-		exit(5);
-
 		reg.PC += 1;
 	}
 
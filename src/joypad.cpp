@@ -0,0 +1,74 @@
+#include "joypad.hpp"
+
+#include "memory-bus.hpp"
+
+namespace {
+	uint8_t readP1(void * context, const uint16_t /*address*/) {
+		Joypad * joypad = static_cast<Joypad *>(context);
+		uint8_t keys = 0;
+
+		if (!(joypad->select & 0x10)) {
+			keys |= joypad->buttons & 0x0F;
+		}
+		if (!(joypad->select & 0x20)) {
+			keys |= joypad->buttons >> 4;
+		}
+
+		return 0xC0 | joypad->select | (~keys & 0x0F);
+	}
+
+	// Only the select lines are writable
+	void writeP1(void * context, const uint16_t /*address*/, const uint8_t byte) {
+		Joypad * joypad = static_cast<Joypad *>(context);
+		joypad->select = byte & 0x30;
+	}
+}
+
+InputQueue::InputQueue()
+		: head(0)
+		, tail(0) {}
+
+bool InputQueue::push(const InputEvent& event) {
+	size_t head = this->head.load(std::memory_order_relaxed);
+
+	if (head - tail.load(std::memory_order_acquire) == CAPACITY) {
+		return false;
+	}
+
+	buffer[head & (CAPACITY - 1)] = event;
+	this->head.store(head + 1, std::memory_order_release);
+
+	return true;
+}
+
+bool InputQueue::pop(InputEvent& event) {
+	size_t tail = this->tail.load(std::memory_order_relaxed);
+
+	if (tail == head.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	event = buffer[tail & (CAPACITY - 1)];
+	this->tail.store(tail + 1, std::memory_order_release);
+
+	return true;
+}
+
+Joypad::Joypad()
+		: select(0x30)
+		, buttons(0) {}
+
+void Joypad::registerIO(MemoryBus& memoryBus) {
+	memoryBus.registerIO(0xFF00, readP1, writeP1, this);
+}
+
+void Joypad::setButton(Button button, bool pressed) {
+	uint8_t mask = 1 << static_cast<uint8_t>(button);
+
+	if (pressed) {
+		buttons |= mask;
+	}
+	else {
+		buttons &= ~mask;
+	}
+}
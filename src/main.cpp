@@ -10,9 +10,11 @@
 #include <GL/gl.h>
 #include <cxxopts.hpp>
 
+#include "emulation-thread.hpp"
 #include "motherboard.hpp"
+#include "palette.hpp"
+#include "trace.hpp"
 
-#include "bitmap.hpp"
 #include "texture.hpp"
 
 #ifdef main
@@ -21,6 +23,11 @@
 int main(int argc, char** argv) {
 	std::string gameFilename;
 	bool DEBUG = false;
+	bool renderThread = false;
+	bool pixelBuffers = false;
+	bool layerCache = false;
+	bool turbo = false;
+	unsigned int turboSpeed = 0;
 
 	cxxopts::Options options("GameBoy", "Nintendo Game Boy emulator built in C++");
 
@@ -29,17 +36,43 @@ int main(int argc, char** argv) {
 			("d,debug", "Enable debugging")
 			("f,file", "ROM File name", cxxopts::value<std::string>())
 			("h,help", "Help menu")
+			("render-thread", "Draw scanlines on a separate thread")
+			("pbo", "Upload frames through double buffered pixel buffer objects")
+			("layer-cache", "Draw the background and window from cached tile map layers")
+			("turbo", "Start in fast forward mode, toggled with Tab")
+			("speed", "Fast forward speed multiplier of at least 2, 0 for uncapped", cxxopts::value<unsigned int>()->default_value("0"))
+#ifdef GAMEBOY_TRACE
+			("t,trace", "Binary execution trace output file", cxxopts::value<std::string>())
+#endif
 			;
 
 		auto result = options.parse(argc, argv);
 
 		DEBUG = result.count("d");
+		renderThread = result.count("render-thread");
+		pixelBuffers = result.count("pbo");
+		layerCache = result.count("layer-cache");
+		turbo = result.count("turbo");
+		turboSpeed = result["speed"].as<unsigned int>();
 
 		if (result.count("h")) {
 			std::cout << options.help({"", "Group"}) << std::endl;
 			return 0;
 		}
 
+#ifdef GAMEBOY_TRACE
+		if (result.count("t") && !Trace::ref().open(result["t"].as<std::string>())) {
+			std::cerr << "Could not open trace file! Exiting..." << std::endl;
+			return 1;
+		}
+#endif
+
+		// Tab would switch between two identical speeds
+		if (turboSpeed == 1) {
+			std::cerr << "Fast forward speed has to be at least 2, or 0 for uncapped! Exiting..." << std::endl;
+			return 1;
+		}
+
 		if (result.count("f")) {
 			gameFilename = result["f"].as<std::string>();
 		}
@@ -64,47 +97,57 @@ int main(int argc, char** argv) {
 
 	Motherboard motherboard;
 
-	motherboard.loadCartridge(gameFilename);
-	motherboard.loadBootROM();
+	if (!motherboard.loadCartridge(gameFilename) || !motherboard.loadBootROM()) {
+		return 1;
+	}
+	motherboard.setThreadedRendering(renderThread);
+	motherboard.setLayerCache(layerCache);
 
 	std::string gameTitle = motherboard.getTitle();
 
 	Application app;
-	Window& window = app.createWindow("WIT GB Emulator - " + gameTitle, 800, 600);
+	Window& window = app.createWindow("WIT GB Emulator - " + gameTitle, 160 * 4, 144 * 4);
 	auto& renderDevice = window.getRenderDevice();
 
-	Bitmap bmp(64, 64);
-	auto data = bmp.getData();
+	Texture screen(160, 144, GL_RGBA8, nullptr, GL_RGBA, GL_UNSIGNED_BYTE);
+	screen.usePixelBuffers(pixelBuffers);
 
-	for (int y = 0, i = 0; y < 64; ++y) {
-		for (int x = 0; x < 64; ++x, i += 3) {
-			data[i] = 4 * x;
-			data[i + 1] = 4 * y;
-			data[i + 2] = 0;
-		}
-	}
+	Palette palette;
+	uint64_t shownFrame = 0;
 
-	Texture tex(bmp);
+	// The emulator runs at its own pace, this loop only presents whatever frame is newest
+	EmulationThread emulation(motherboard);
+	app.setInputQueue(&emulation.getInput());
+	emulation.setRefreshRate(window.getRefreshRate());
+	emulation.setSpeed(turbo ? turboSpeed : 1);
+	app.setTurbo(turbo);
+	emulation.start();
 
-	int frameCounter = 0;  // TODO: Replace frame counter with V-Blank interrupts
 	while (app.isRunning()) {
-		motherboard.clock();
+		app.pollEvents();
 
-		if (frameCounter % 70220 == 0) {  // Not exact
-			app.pollEvents();
-
-			renderDevice.clear();
-			renderDevice.drawTexturedQuad(tex);
+		if (app.isTurbo() != turbo) {
+			turbo = app.isTurbo();
+			emulation.setSpeed(turbo ? turboSpeed : 1);
+		}
 
-			window.swapBuffers();
+		// Only upload when the emulator completed a new frame
+		Display::Frame frame = motherboard.acquireFrame();
+		if (frame.sequence != shownFrame) {
+			palette.convert(*frame.pixels, screen.beginUpdate(), PixelFormat::RGBA8888);
+			screen.endUpdate();
+			shownFrame = frame.sequence;
 		}
-		
-		frameCounter++;
 
-		if (frameCounter == 70220)
-			frameCounter = 0;
+		renderDevice.clear();
+		renderDevice.drawTexturedQuad(screen);
+
+		window.swapBuffers();
+		emulation.presented();
 	}
 
+	emulation.stop();
+
 	return 0;
 }
 
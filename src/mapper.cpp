@@ -0,0 +1,296 @@
+#include "mapper.hpp"
+
+#include "cartridge.hpp"
+
+#include <cstdio>
+
+std::unique_ptr<MBC::Mapper> MBC::create(Cartridge& cartridge) {
+	switch (cartridge.header.type) {
+		case 0x00:  // ROM
+		case 0x08:  // ROM+RAM
+		case 0x09:  // ROM+RAM+BATTERY
+			return std::make_unique<ROMOnly>(cartridge);
+		case 0x01 ... 0x03:  // MBC1, MBC1+RAM, MBC1+RAM+BATTERY
+			return std::make_unique<MBC1>(cartridge);
+		case 0x05 ... 0x06:  // MBC2, MBC2+BATTERY
+			return std::make_unique<MBC2>(cartridge);
+		case 0x0F ... 0x13:  // MBC3+TIMER+BATTERY ... MBC3+RAM+BATTERY
+			return std::make_unique<MBC3>(cartridge);
+		case 0x19 ... 0x1E:  // MBC5 ... MBC5+RUMBLE+RAM+BATTERY
+			return std::make_unique<MBC5>(cartridge);
+		default:
+			fprintf(stderr, "ERROR: Unsupported cartridge type: 0x%X, treating it as ROM only\n", cartridge.header.type);
+			return std::make_unique<ROMOnly>(cartridge);
+	}
+}
+
+// ## Mapper ##
+
+MBC::Mapper::Mapper(Cartridge& cartridge)
+		: cartridge(cartridge)
+		, ROMBank0(nullptr)
+		, ROMBankN(nullptr)
+		, RAMBank(nullptr) {}
+
+MBC::Mapper::~Mapper() {
+
+}
+
+uint8_t MBC::Mapper::readRAM(const uint16_t /*address*/) const {
+	return 0xFF;
+}
+
+void MBC::Mapper::writeRAM(const uint16_t /*address*/, const uint8_t /*byte*/) {
+
+}
+
+const uint8_t * MBC::Mapper::getROMBank0() const {
+	return ROMBank0;
+}
+
+const uint8_t * MBC::Mapper::getROMBankN() const {
+	return ROMBankN;
+}
+
+uint8_t * MBC::Mapper::getRAMBank() const {
+	return RAMBank;
+}
+
+// Returns true if any bank moved, only then the memory bus has to remap its pages
+bool MBC::Mapper::setBanks(unsigned int bank0, unsigned int bankN, unsigned int RAMBankNumber, bool RAMEnable) {
+	const uint8_t * oldROMBank0 = ROMBank0;
+	const uint8_t * oldROMBankN = ROMBankN;
+	uint8_t * oldRAMBank = RAMBank;
+
+	ROMBank0 = cartridge.getROMBank(bank0);
+	ROMBankN = cartridge.getROMBank(bankN);
+	RAMBank = RAMEnable ? cartridge.getRAMBank(RAMBankNumber) : nullptr;
+
+	return ROMBank0 != oldROMBank0 || ROMBankN != oldROMBankN || RAMBank != oldRAMBank;
+}
+
+// ## ROM only ##
+
+MBC::ROMOnly::ROMOnly(Cartridge& cartridge)
+		: Mapper(cartridge) {
+	setBanks(0, 1, 0, true);
+}
+
+bool MBC::ROMOnly::write(const uint16_t /*address*/, const uint8_t /*byte*/) {
+	return false;
+}
+
+// ## MBC1 ##
+
+MBC::MBC1::MBC1(Cartridge& cartridge)
+		: Mapper(cartridge)
+		, RAMEnable(false)
+		, bankLow(1)
+		, bankHigh(0)
+		, mode(0) {
+	update();
+}
+
+bool MBC::MBC1::write(const uint16_t address, const uint8_t byte) {
+	switch (address) {
+		case 0x0000 ... 0x1FFF:  // RAM enable
+			RAMEnable = (byte & 0x0F) == 0x0A;
+			break;
+		case 0x2000 ... 0x3FFF:  // ROM bank number, lower 5 bits
+			bankLow = byte & 0x1F;
+			break;
+		case 0x4000 ... 0x5FFF:  // RAM bank number or upper 2 bits of the ROM bank number
+			bankHigh = byte & 0x03;
+			break;
+		case 0x6000 ... 0x7FFF:  // Banking mode select
+			mode = byte & 0x01;
+			break;
+	}
+
+	return update();
+}
+
+bool MBC::MBC1::update() {
+	unsigned int bankN = (bankHigh << 5) | (bankLow == 0 ? 1 : bankLow);
+
+	if (mode == 0) {
+		return setBanks(0, bankN, 0, RAMEnable);
+	}
+	else {
+		return setBanks(bankHigh << 5, bankN, bankHigh, RAMEnable);
+	}
+}
+
+// ## MBC2 ##
+
+MBC::MBC2::MBC2(Cartridge& cartridge)
+		: Mapper(cartridge)
+		, RAMEnable(false)
+		, bank(1) {
+	RAM.fill(0);
+	setBanks(0, bank, 0, false);
+}
+
+bool MBC::MBC2::write(const uint16_t address, const uint8_t byte) {
+	if (address > 0x3FFF) {
+		return false;
+	}
+
+	// Bit 8 of the address selects between RAM enable and ROM bank number
+	if (address & 0x0100) {
+		bank = (byte & 0x0F) == 0 ? 1 : byte & 0x0F;
+		return setBanks(0, bank, 0, false);
+	}
+
+	RAMEnable = (byte & 0x0F) == 0x0A;
+	return false;
+}
+
+uint8_t MBC::MBC2::readRAM(const uint16_t address) const {
+	return RAMEnable ? (RAM[address & 0x1FF] | 0xF0) : 0xFF;
+}
+
+void MBC::MBC2::writeRAM(const uint16_t address, const uint8_t byte) {
+	if (RAMEnable) {
+		RAM[address & 0x1FF] = byte & 0x0F;
+	}
+}
+
+// ## MBC3 ##
+
+MBC::MBC3::MBC3(Cartridge& cartridge)
+		: Mapper(cartridge)
+		, RAMEnable(false)
+		, bank(1)
+		, select(0)
+		, latch(0xFF)
+		, RTCSeconds(0)
+		, RTCStart(std::time(nullptr))
+		, RTCHalt(false)
+		, RTCCarry(false) {
+	RTCLatched.fill(0);
+	update();
+}
+
+bool MBC::MBC3::write(const uint16_t address, const uint8_t byte) {
+	switch (address) {
+		case 0x0000 ... 0x1FFF:  // RAM and RTC enable
+			RAMEnable = (byte & 0x0F) == 0x0A;
+			break;
+		case 0x2000 ... 0x3FFF:  // ROM bank number
+			bank = (byte & 0x7F) == 0 ? 1 : byte & 0x7F;
+			break;
+		case 0x4000 ... 0x5FFF:  // RAM bank number or RTC register select
+			select = byte;
+			break;
+		case 0x6000 ... 0x7FFF:  // Writing 0 then 1 latches the clock
+			if (latch == 0x00 && byte == 0x01) {
+				RTCLatch();
+			}
+			latch = byte;
+			return false;
+	}
+
+	return update();
+}
+
+uint8_t MBC::MBC3::readRAM(const uint16_t /*address*/) const {
+	if (RAMEnable && select >= 0x08 && select <= 0x0C) {
+		return RTCLatched[select - 0x08];
+	}
+
+	return 0xFF;
+}
+
+void MBC::MBC3::writeRAM(const uint16_t /*address*/, const uint8_t byte) {
+	if (!RAMEnable || select < 0x08 || select > 0x0C) {
+		return;
+	}
+
+	int64_t now = RTCNow();
+	int64_t seconds = now % 60;
+	int64_t minutes = (now / 60) % 60;
+	int64_t hours = (now / 3600) % 24;
+	int64_t days = (now / 86400) % 512;
+
+	switch (select) {
+		case 0x08:
+			seconds = byte % 60;
+			break;
+		case 0x09:
+			minutes = byte % 60;
+			break;
+		case 0x0A:
+			hours = byte % 24;
+			break;
+		case 0x0B:
+			days = (days & 0x100) | byte;
+			break;
+		case 0x0C:
+			days = (days & 0xFF) | ((byte & 0x01) << 8);
+			RTCHalt = byte & 0x40;
+			RTCCarry = byte & 0x80;
+			break;
+	}
+
+	RTCSeconds = seconds + (minutes * 60) + (hours * 3600) + (days * 86400);
+	RTCStart = std::time(nullptr);
+}
+
+int64_t MBC::MBC3::RTCNow() const {
+	return RTCHalt ? RTCSeconds : RTCSeconds + (std::time(nullptr) - RTCStart);
+}
+
+void MBC::MBC3::RTCLatch() {
+	int64_t now = RTCNow();
+	int64_t days = now / 86400;
+
+	if (days >= 512) {
+		RTCCarry = true;
+	}
+
+	RTCLatched[0] = now % 60;
+	RTCLatched[1] = (now / 60) % 60;
+	RTCLatched[2] = (now / 3600) % 24;
+	RTCLatched[3] = days & 0xFF;
+	RTCLatched[4] = ((days >> 8) & 0x01) | (RTCHalt ? 0x40 : 0) | (RTCCarry ? 0x80 : 0);
+}
+
+bool MBC::MBC3::update() {
+	return setBanks(0, bank, select & 0x03, RAMEnable && select <= 0x03);
+}
+
+// ## MBC5 ##
+
+MBC::MBC5::MBC5(Cartridge& cartridge)
+		: Mapper(cartridge)
+		, RAMEnable(false)
+		, bank(1)
+		, RAMBankNumber(0) {
+	update();
+}
+
+bool MBC::MBC5::write(const uint16_t address, const uint8_t byte) {
+	switch (address) {
+		case 0x0000 ... 0x1FFF:  // RAM enable
+			RAMEnable = (byte & 0x0F) == 0x0A;
+			break;
+		case 0x2000 ... 0x2FFF:  // ROM bank number, lower 8 bits
+			bank = (bank & 0x100) | byte;
+			break;
+		case 0x3000 ... 0x3FFF:  // ROM bank number, bit 8
+			bank = (bank & 0xFF) | ((byte & 0x01) << 8);
+			break;
+		case 0x4000 ... 0x5FFF:  // RAM bank number
+			RAMBankNumber = byte & 0x0F;
+			break;
+		default:
+			return false;
+	}
+
+	return update();
+}
+
+bool MBC::MBC5::update() {
+	return setBanks(0, bank, RAMBankNumber, RAMEnable);
+}
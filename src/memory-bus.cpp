@@ -3,23 +3,56 @@
 #include <cstdlib>
 #include <cstdio>
 
-uint8_t MemoryBus::read(const uint16_t address) const {
+namespace {
+	uint8_t readBootROMDisable(void * /*context*/, const uint16_t /*address*/) {
+		return 0xFF;
+	}
+
+	// Any non-zero write unmaps the boot ROM until the next reset
+	void writeBootROMDisable(void * context, const uint16_t /*address*/, const uint8_t byte) {
+		MemoryBus * memoryBus = static_cast<MemoryBus *>(context);
+
+		if (byte != 0 && memoryBus->bootROMEnable) {
+			memoryBus->bootROMEnable = false;
+			memoryBus->mapPages();
+		}
+	}
+}
+
+MemoryBus::MemoryBus()
+		: interruptsEnable(false)
+		, cartridge(nullptr)
+		, display(nullptr)
+		, bootROMEnable(false) {
+	readPages.fill(nullptr);
+	writePages.fill(nullptr);
+
+	io.fill({nullptr, nullptr, nullptr, nullptr});
+	IO.fill(0);
+	ioReported.fill(false);
+
+	// Registers without an emulated component are plain storage so software reads back what it wrote
+	registerIO(0xFF01, &IO[0x01]);  // SB
+	registerIO(0xFF02, &IO[0x02]);  // SC
+	for (uint16_t address = 0xFF04; address <= 0xFF07; address++) {  // DIV, TIMA, TMA, TAC
+		registerIO(address, &IO[address - 0xFF00]);
+	}
+	registerIO(0xFF0F, &IO[0x0F]);  // IF
+	for (uint16_t address = 0xFF10; address <= 0xFF3F; address++) {  // Sound and wave pattern RAM
+		registerIO(address, &IO[address - 0xFF00]);
+	}
+	registerIO(0xFF50, readBootROMDisable, writeBootROMDisable, this);
+}
+
+uint8_t MemoryBus::readHandler(const uint16_t address) const {
 	switch (address) {
-		case 0x0000 ... 0x3FFF:  // 16K ROM bank 0, from cartridge, usually a fixed bank
-			return cartridge->ROM[address];
-		case 0x4000 ... 0x7FFF:  // 16K ROM bank 1-N, from cartridge, switchable bank via MB (if any)
-			return cartridge->rombank.bank[cartridge->rombank.bankPtr][address - 0x4000];
+		case 0x0000 ... 0x7FFF:  // Boot ROM and cartridge ROM are always mapped, only reached without a cartridge
+			return 0xFF;
 		case 0x8000 ... 0x9FFF:  // 8K Video RAM, only bank 0 switchable in non-CGB mode, 0/1 in CGB mode
 			return display->VRAMEnable ? display->VRAM[address - 0x8000] : 0;
 		case 0xA000 ... 0xBFFF:  // 8K External RAM, in cartridge, switchable bank if any
-			switch (cartridge->header.type) {
-				case 0:
-					return cartridge->rambank.bank[cartridge->rambank.bankPtr][address - 0xA000];
-				case 1 ... 3:
-					return ERAMEnable ? cartridge->rambank.bank[cartridge->rambank.bankPtr][address - 0xA000] : 0;
-				default:
-					return 0;
-			}
+			// Only reached while external RAM is not mapped (disabled, RTC registers or MBC2 RAM)
+			return cartridge && cartridge->mapper ? cartridge->mapper->readRAM(address) : 0xFF;
 		case 0xC000 ... 0xDFFF:  // 4K Work RAM bank 0-1, banks 2-7 switchable in CGB mode
 			return WRAM[address - 0xC000];
 		case 0xE000 ... 0xFDFF:  // Echo RAM, a copy of the bank of RAM below it. Works both ways
@@ -33,71 +66,25 @@ uint8_t MemoryBus::read(const uint16_t address) const {
 		case 0xFFFF:  // Interrupts Enable Register
 			return interruptsEnable;
 		default:
-			// 0xFEA0 ... 0xFEFF Not usable
-			fprintf(stderr,"ERROR: Attempt to read non-readable memory address: 0x%X\n", address);
-			exit(1);
-			// TODO: handle this better
+			// 0xFEA0 ... 0xFEFF Not usable, reads 0 on the DMG
+			return 0;
 	}
 }
 
-void MemoryBus::write(const uint16_t address, const uint8_t byte) {
+void MemoryBus::writeHandler(const uint16_t address, const uint8_t byte) {
 	switch (address) {
-		case 0x0000 ... 0x1FFF:  // 16K ROM bank 0, from cartridge, usually a fixed bank
-			switch (cartridge->header.type) {
-				case 0x01 ... 0x03:
-					ERAMEnable = (byte & 0xF == 0xA);
-					break;
-			}
-			break;
-		case 0x2000 ... 0x3FFF:  // 16K ROM bank 0, from cartridge, usually a fixed bank
-			switch (cartridge->header.type) {
-				case 0x01:
-					if (cartridge->header.ROMSize > 0x04) {
-						if (byte == 0x00) {
-							cartridge->rombank.bankPtr = 0x01;
-						}
-						else {
-							cartridge->rombank.bankPtr = (cartridge->rambank.bankPtr << 5 | (byte & 0x1F));
-						}
-					}
-					else {
-						if (byte == 0x00) {
-							cartridge->rombank.bankPtr = 0x01;
-						}
-						else {
-							cartridge->rombank.bankPtr = byte & 0x1F;
-						}
-					}
-					break;
-			}
-			break;
-		case 0x4000 ... 0x5FFF:  // 16K ROM bank 1-N, from cartridge, switchable bank via MB (if any)
-			switch (cartridge->header.type) {
-				case 0x01 ... 0x03:
-					if (cartridge->header.RAMSize == 0x03 && ERAMEnable) {
-						cartridge->rambank.bankPtr = byte & 0x03;
-					}
-					break;
-			}
-			break;
-		case 0x6000 ... 0x7FFF:  // 16K ROM bank 1-N, from cartridge, switchable bank via MB (if any)
-			if (cartridge->header.type == 0x01) {
-				bankingMode = byte & 0x01;
+		case 0x0000 ... 0x7FFF:  // Bank controller registers
+			if (cartridge->mapper && cartridge->mapper->write(address, byte)) {
+				mapPages();
 			}
 			break;
 		case 0x8000 ... 0x9FFF:  // 8K Video RAM, only bank 0 switchable in non-CGB mode, 0/1 in CGB mode
-			display->VRAM[address - 0x8000] = byte;
+			display->writeVRAM(address - 0x8000, byte);
 			break;
 		case 0xA000 ... 0xBFFF:  // 8K External RAM, in cartridge, switchable bank if any
-			switch (cartridge->header.type) {
-				case 0x00:
-					cartridge->rambank.bank[cartridge->rambank.bankPtr][address - 0xA000] = byte;
-					break;
-				case 0x01 ... 0x03:
-					if (ERAMEnable) {
-						cartridge->rambank.bank[cartridge->rambank.bankPtr][address - 0xA000] = byte;
-					}
-					break;
+			// Only reached while external RAM is not mapped (disabled, RTC registers or MBC2 RAM)
+			if (cartridge && cartridge->mapper) {
+				cartridge->mapper->writeRAM(address, byte);
 			}
 			break;
 		case 0xC000 ... 0xDFFF:  // 4K Work RAM bank 0-1, banks 2-7 switchable in CGB mode
@@ -107,7 +94,7 @@ void MemoryBus::write(const uint16_t address, const uint8_t byte) {
 			WRAM[address - 0xE000] = byte;
 			break;
 		case 0xFE00 ... 0xFE9F:  // Sprite Attribute Table (OAM)
-			display->OAM[address - 0xFE00] = byte;
+			display->writeOAM(address - 0xFE00, byte);
 			break;
 		case 0xFF00 ... 0xFF7F:  // IO Registers
 			writeIO(address, byte);
@@ -119,91 +106,109 @@ void MemoryBus::write(const uint16_t address, const uint8_t byte) {
 			interruptsEnable = byte;
 			break;
 		default:
-			// 0xFEA0 ... 0xFEFF Not usable
-			fprintf(stderr,"ERROR: Attempt to write non-writeable memory address: 0x%X\n", address);
-			exit(1);
-			// TODO: handle this better
+			// 0xFEA0 ... 0xFEFF Not usable, some games clear it along with OAM
+			break;
 	}
 }
 
 void MemoryBus::loadCartridge(Cartridge * cart) {
 	this->cartridge = cart;
+	mapPages();
 }
 
 void MemoryBus::loadDisplay(Display * display) {
 	this->display = display;
+	display->registerIO(*this);
+	mapPages();
+}
+
+// Rebuilds the page tables, needs to be called whenever a bank switch changes the memory map
+void MemoryBus::mapPages() {
+	readPages.fill(nullptr);
+	writePages.fill(nullptr);
+
+	if (cartridge && cartridge->mapper) {
+		MBC::Mapper& mapper = *cartridge->mapper;
+
+		if (mapper.getROMBank0()) {
+			mapRead(0x0000, 0x4000, mapper.getROMBank0());
+		}
+		if (mapper.getROMBankN()) {
+			mapRead(0x4000, 0x4000, mapper.getROMBankN());
+		}
+		if (mapper.getRAMBank()) {
+			mapRead(0xA000, 0x2000, mapper.getRAMBank());
+			mapWrite(0xA000, 0x2000, mapper.getRAMBank());
+		}
+	}
+
+	if (bootROMEnable) {
+		readPages[0x00] = bootROM.data();  // Overlays the first page of ROM bank 0
+	}
+
+	// VRAM writes are left to the handler so the display can invalidate decoded tiles and flush deferred lines
+	if (display && display->VRAMEnable) {
+		mapRead(0x8000, 0x2000, display->VRAM.data());
+	}
+
+	mapRead(0xC000, 0x2000, WRAM.data());
+	mapWrite(0xC000, 0x2000, WRAM.data());
+	mapRead(0xE000, 0x1E00, WRAM.data());  // Echo RAM, 0xFE00 onwards is OAM and IO
+	mapWrite(0xE000, 0x1E00, WRAM.data());
+}
+
+void MemoryBus::mapRead(const uint16_t start, const unsigned int size, const uint8_t * memory) {
+	for (unsigned int i = 0; i < size / PAGE_SIZE; i++) {
+		readPages[(start / PAGE_SIZE) + i] = memory + (i * PAGE_SIZE);
+	}
+}
+
+void MemoryBus::mapWrite(const uint16_t start, const unsigned int size, uint8_t * memory) {
+	for (unsigned int i = 0; i < size / PAGE_SIZE; i++) {
+		writePages[(start / PAGE_SIZE) + i] = memory + (i * PAGE_SIZE);
+	}
 }
 
 uint8_t MemoryBus::readIO(const uint16_t address) const {
-	switch (address) {
-		case 0xFF40:
-			return display->LCDC;
-		case 0xFF41:
-			return display->LCDCSTAT;
-		case 0xFF42:
-			return display->SCY;
-		case 0xFF43:
-			return display->SCX;
-		case 0xFF44:
-			return display->LY;
-		case 0xFF45:
-			return display->LYC;
-		case 0xFF47:
-			return display->BGP;
-		case 0xFF48:
-			return display->OBP0;
-		case 0xFF49:
-			return display->OBP1;
-		case 0xFF4A:
-			return display->WY;
-		case 0xFF4B:
-			return display->WX;
-		default:
-			fprintf(stderr,"ERROR: Attempt to read non-readable/not implemented I/O address: 0x%X\n", address);
-			// exit(1);
-			return 0xFF;
-		// TODO: add the rest of the IO registers
+	const IOPort& port = io[address - 0xFF00];
+
+	if (port.read) {
+		return port.read(port.context, address);
 	}
+	if (port.data) {
+		return *port.data;
+	}
+
+	unmapped(address, "read");
+	return 0xFF;
 }
 
 void MemoryBus::writeIO(const uint16_t address, const uint8_t byte) {
-	switch (address) {
-		case 0xFF40:
-			display->LCDC = byte;
-			break;
-		case 0xFF41:
-			display->LCDCSTAT = byte;
-			break;
-		case 0xFF42:
-			display->SCY = byte;
-			break;
-		case 0xFF43:
-			display->SCX = byte;
-			break;
-		case 0xFF44:
-			display->LY = byte;
-			break;
-		case 0xFF45:
-			display->LYC = byte;
-			break;
-		case 0xFF47:
-			display->BGP = byte;
-			break;
-		case 0xFF48:
-			display->OBP0 = byte;
-			break;
-		case 0xFF49:
-			display->OBP1 = byte;
-			break;
-		case 0xFF4A:
-			display->WY = byte;
-			break;
-		case 0xFF4B:
-			display->WX = byte;
-			break;
-		default:
-			fprintf(stderr,"ERROR: Attempt to write non-writeable/not implemented I/O address: 0x%X\n", address);
-			// exit(1);
-		// TODO: add the rest of the IO registers
+	const IOPort& port = io[address - 0xFF00];
+
+	if (port.write) {
+		port.write(port.context, address, byte);
+	}
+	else if (port.data) {
+		*port.data = byte;
+	}
+	else {
+		unmapped(address, "write");
 	}
-}
\ No newline at end of file
+}
+
+void MemoryBus::registerIO(const uint16_t address, uint8_t * data) {
+	io[address - 0xFF00] = {data, nullptr, nullptr, nullptr};
+}
+
+void MemoryBus::registerIO(const uint16_t address, IOPort::Read read, IOPort::Write write, void * context) {
+	io[address - 0xFF00] = {nullptr, read, write, context};
+}
+
+// Reports an access to an unmapped IO register, only once per address to keep stderr off the hot path
+void MemoryBus::unmapped(const uint16_t address, const char * access) const {
+	if (!ioReported[address - 0xFF00]) {
+		ioReported[address - 0xFF00] = true;
+		fprintf(stderr,"ERROR: Attempt to %s not implemented I/O address: 0x%X (further accesses not reported)\n", access, address);
+	}
+}
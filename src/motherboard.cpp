@@ -1,6 +1,11 @@
 #include "motherboard.hpp"
 
+#include "rom-cache.hpp"
+#include "trace.hpp"
+
 Motherboard::Motherboard() {
+	frameComplete = false;
+
 	loadMemory();
 	loadInterrupts();
 }
@@ -10,88 +15,148 @@ Motherboard::~Motherboard() {
 }
 
 void Motherboard::clock() {
+	Event event;
+
 	processor.step();
-	display.clock();
+	scheduler.advance(1);
+
+	while (scheduler.popDue(event)) {
+		handleEvent(event);
+	}
 }
 
-void Motherboard::loadBootROM() {
-	std::vector<uint8_t> * data = new std::vector<uint8_t>;
+// Runs the CPU for at least `cycles` T-cycles, returns the cycles actually run which can
+// overshoot by one instruction
+unsigned int Motherboard::runFor(unsigned int cycles) {
+	uint64_t start = scheduler.now();
+
+	runUntil(start + cycles);
+
+	return scheduler.now() - start;
+}
 
-	*data = readFile("../res/DMG_ROM.bin");
+// Runs the CPU uninterrupted up to the earliest scheduled deadline, handles whatever came due
+// and repeats until the timestamp is reached
+void Motherboard::runUntil(uint64_t timestamp) {
+	Event event;
 
-	for (int i = 0; i < 0xFF; i++) {
-		cartridge.ROM[i] = (*data)[i];
-		cartridge.rombank.bank[0][i] = (*data)[i];
+	while (true) {
+		while (scheduler.popDue(event)) {
+			handleEvent(event);
+		}
+
+		if (scheduler.now() >= timestamp) {
+			break;
+		}
+
+		uint64_t deadline = std::min(timestamp, scheduler.nextDeadline());
+		scheduler.advance(processor.run(deadline - scheduler.now()));
 	}
+}
+
+// Runs until the end of the current frame
+void Motherboard::runFrame() {
+	frameComplete = false;
 
-	delete data;
+	while (!frameComplete) {
+		runUntil(scheduler.nextDeadline());
+	}
+
+#ifdef GAMEBOY_TRACE
+	Trace::ref().flush();
+#endif
 }
 
-void Motherboard::loadCartridge(std::string filename) {
-	std::vector<uint8_t> * data = new std::vector<uint8_t>;
+void Motherboard::handleEvent(Event event) {
+	switch (event) {
+		case Event::PPU:
+			display.sync();
+			display.schedule();
+			break;
+		case Event::FrameEnd:
+			display.sync();
+			frameComplete = true;
+			// Frames are a fixed length from the previous boundary so CPU overshoot never accumulates
+			scheduler.schedule(Event::FrameEnd, scheduler.now() - (scheduler.now() % CYCLES_PER_FRAME) + CYCLES_PER_FRAME);
+			break;
+		default:
+			break;
+	}
+}
 
-	*data = readFile(filename);
+Scheduler& Motherboard::getScheduler() {
+	return scheduler;
+}
 
-	// Cartridge metadata
-	for (int i = 0; i < 16; i++) {
-		cartridge.header.title[i] = (*data)[0x0134+i];  // Read game title bytes
+// Returns false when the boot ROM file could not be read
+bool Motherboard::loadBootROM(std::string filename) {
+	std::vector<uint8_t> data = readFile(filename);
+
+	if (data.empty()) {
+		std::cerr << "Could not open boot ROM file: " << filename << std::endl;
+		return false;
 	}
-	cartridge.header.type = (*data)[0x0147];
-	cartridge.header.ROMSize = (*data)[0x0148];
-	cartridge.header.RAMSize = (*data)[0x0149];
-	cartridge.header.CGB = (*data)[0x0143] == 0x80;  // Check for Game Boy Color cartridge
-
-	for (int i = 0; i < 0x3FFF; i++) {
-		cartridge.ROM[i] = (*data)[i];
-		cartridge.rombank.bank[0][i] = (*data)[i];
+
+	// The boot ROM is overlaid on the first page of the cartridge until it is disabled through 0xFF50
+	for (int i = 0; i < BOOT_ROM_SIZE && i < (int) data.size(); i++) {
+		memoryBus->bootROM[i] = data[i];
 	}
-	for (int i = 1; i < 256; i++) {
-		for (int j = 0; j < 0x3FFF; j++) {
-			if ((i * 0x4000) + j < data->size()) {
-				cartridge.rombank.bank[i][j] = (*data)[(i * 0x4000) + j];
-			}
-		}
+
+	memoryBus->bootROMEnable = true;
+	memoryBus->mapPages();
+
+	return true;
+}
+
+bool Motherboard::loadCartridge(std::string filename) {
+	std::shared_ptr<const ROMImage> image = ROMCache::ref().load(filename);
+
+	if (!image) {
+		std::cerr << "Could not open ROM file: " << filename << std::endl;
+		return false;
 	}
 
-	delete data;
+	const uint8_t * data = image->data();  // Always at least two banks, so the header is present
+
+	// Cartridge metadata
+	for (int i = 0; i < 16; i++) {
+		cartridge.header.title[i] = data[0x0134+i];  // Read game title bytes
+	}
+	cartridge.header.type = data[0x0147];
+	cartridge.header.ROMSize = data[0x0148];
+	cartridge.header.RAMSize = data[0x0149];
+	cartridge.header.CGB = data[0x0143] == 0x80;  // Check for Game Boy Color cartridge
+
+	cartridge.load(std::move(image));
+
+	memoryBus->mapPages();  // Cartridge type decides how external RAM is mapped
+
+	return true;
 }
 
 void Motherboard::loadMemory() {
 	memoryBus = &processor.getMemory();
 	memoryBus->loadCartridge(&cartridge);  // Pass cartridge to memory bus
 	memoryBus->loadDisplay(&display);
+	joypad.registerIO(*memoryBus);
+	display.loadScheduler(&scheduler);
 }
 
 void Motherboard::loadInterrupts() {
-	
+	scheduler.schedule(Event::FrameEnd, scheduler.now() + CYCLES_PER_FRAME);
 }
 
 std::vector<uint8_t> Motherboard::readFile(std::string filename)
 {
-    // open the file:
     std::ifstream file(filename, std::ios::binary | std::ios::ate);
-
-    // Stop eating new lines in binary mode!!!
-    file.unsetf(std::ios::skipws);
-
-    // get its size:
-    std::streampos fileSize;
-
-    file.seekg(0, std::ios::end);
-    fileSize = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    // reserve capacity
     std::vector<uint8_t> vec;
 
-    // read the data:
-	char b;
     if (file) {
-		for (int i = 0; i < fileSize; i++) {
-			file.read(&b, 1);
-			vec.push_back((uint8_t) b);
-		}
-	}
+        vec.resize(file.tellg());
+        file.seekg(0, std::ios::beg);
+        file.read(reinterpret_cast<char *>(vec.data()), vec.size());
+        vec.resize(file.gcount());
+    }
 
     return vec;
 }
@@ -101,6 +166,39 @@ std::string Motherboard::getTitle() {
 	return str;
 }
 
-std::array<std::array<uint8_t, 160>, 144> Motherboard::getFrameBuffer() {
-	return display.getFrameBuffer();
-}
\ No newline at end of file
+// Latest completed frame without copying it, see Display::acquireFrame()
+Display::Frame Motherboard::acquireFrame() {
+	return display.acquireFrame();
+}
+
+bool Motherboard::isFramePending() const {
+	return display.isFramePending();
+}
+
+// Draws each frame in one batch at VBlank from logged line registers instead of line by line
+void Motherboard::setDeferredRendering(bool enable) {
+	display.setDeferredRendering(enable);
+}
+
+// Draws every interval-th frame, 0 only draws frames asked for with requestFrame(). Timing and interrupts are unaffected
+void Motherboard::setFrameSkip(unsigned int interval) {
+	display.setFrameSkip(interval);
+}
+
+void Motherboard::requestFrame() {
+	display.requestFrame();
+}
+
+// Copies background and window lines out of cached 256x256 layers instead of fetching their tiles
+void Motherboard::setLayerCache(bool enable) {
+	display.setLayerCache(enable);
+}
+
+// Draws scanlines on a separate thread so pixel generation overlaps CPU emulation
+void Motherboard::setThreadedRendering(bool enable) {
+	display.setThreadedRendering(enable);
+}
+
+void Motherboard::setButton(Button button, bool pressed) {
+	joypad.setButton(button, pressed);
+}
@@ -0,0 +1,267 @@
+#include "palette.hpp"
+
+#include <cstring>
+
+#if !defined(GAMEBOY_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PALETTE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+	const unsigned int WIDTH = 160;
+
+	using RowKernel = void (*)(const uint8_t * in, uint8_t * out, const void * table);
+
+	void rowRGBA(const uint8_t * in, uint8_t * out, const void * table) {
+		const uint32_t * rgba = static_cast<const uint32_t *>(table);
+		for (unsigned int x = 0; x < WIDTH; x++) {
+			std::memcpy(out + x * 4, &rgba[in[x] & 0x03], 4);
+		}
+	}
+
+	void rowRGB(const uint8_t * in, uint8_t * out, const void * table) {
+		const std::array<uint8_t, 3> * rgb = static_cast<const std::array<uint8_t, 3> *>(table);
+		for (unsigned int x = 0; x < WIDTH; x++) {
+			std::memcpy(out + x * 3, rgb[in[x] & 0x03].data(), 3);
+		}
+	}
+
+	void row565(const uint8_t * in, uint8_t * out, const void * table) {
+		const uint16_t * rgb565 = static_cast<const uint16_t *>(table);
+		for (unsigned int x = 0; x < WIDTH; x++) {
+			std::memcpy(out + x * 2, &rgb565[in[x] & 0x03], 2);
+		}
+	}
+
+#if defined(PALETTE_X86) && defined(__SSE2__)
+	// SSE2 has no byte shuffle, shades are picked with their two bits as masks:
+	// bit 0 chooses within 0/1 and 2/3, bit 1 between the two results
+	void rowRGBA_SSE2(const uint8_t * in, uint8_t * out, const void * table) {
+		const uint32_t * rgba = static_cast<const uint32_t *>(table);
+		const __m128i c0 = _mm_set1_epi32(rgba[0]);
+		const __m128i c2 = _mm_set1_epi32(rgba[2]);
+		const __m128i c01 = _mm_set1_epi32(rgba[0] ^ rgba[1]);
+		const __m128i c23 = _mm_set1_epi32(rgba[2] ^ rgba[3]);
+		const __m128i one = _mm_set1_epi8(0x01);
+		const __m128i two = _mm_set1_epi8(0x02);
+
+		for (unsigned int x = 0; x < WIDTH; x += 16) {
+			__m128i shades = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + x));
+			__m128i bit0 = _mm_cmpeq_epi8(_mm_and_si128(shades, one), one);
+			__m128i bit1 = _mm_cmpeq_epi8(_mm_and_si128(shades, two), two);
+
+			// Widens the byte masks to one 32 bit mask per pixel
+			__m128i bit0Words[2] = {_mm_unpacklo_epi8(bit0, bit0), _mm_unpackhi_epi8(bit0, bit0)};
+			__m128i bit1Words[2] = {_mm_unpacklo_epi8(bit1, bit1), _mm_unpackhi_epi8(bit1, bit1)};
+
+			for (int i = 0; i < 4; i++) {
+				__m128i mask0 = (i & 1) ? _mm_unpackhi_epi16(bit0Words[i / 2], bit0Words[i / 2]) : _mm_unpacklo_epi16(bit0Words[i / 2], bit0Words[i / 2]);
+				__m128i mask1 = (i & 1) ? _mm_unpackhi_epi16(bit1Words[i / 2], bit1Words[i / 2]) : _mm_unpacklo_epi16(bit1Words[i / 2], bit1Words[i / 2]);
+
+				__m128i low = _mm_xor_si128(c0, _mm_and_si128(mask0, c01));
+				__m128i high = _mm_xor_si128(c2, _mm_and_si128(mask0, c23));
+				__m128i pixels = _mm_xor_si128(low, _mm_and_si128(mask1, _mm_xor_si128(low, high)));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(out + (x + i * 4) * 4), pixels);
+			}
+		}
+	}
+
+	void row565_SSE2(const uint8_t * in, uint8_t * out, const void * table) {
+		const uint16_t * rgb565 = static_cast<const uint16_t *>(table);
+		const __m128i zero = _mm_setzero_si128();
+		__m128i colors[4];
+		for (int i = 0; i < 4; i++) {
+			colors[i] = _mm_set1_epi16(rgb565[i]);
+		}
+
+		for (unsigned int x = 0; x < WIDTH; x += 8) {
+			__m128i shades = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + x)), zero);
+			__m128i pixels = zero;
+			for (int i = 0; i < 4; i++) {
+				__m128i mask = _mm_cmpeq_epi16(shades, _mm_set1_epi16(i));
+				pixels = _mm_or_si128(pixels, _mm_and_si128(mask, colors[i]));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + x * 2), pixels);
+		}
+	}
+#endif
+
+#ifdef PALETTE_X86
+	// AVX2 looks the shades up directly, with a cross lane permute for 32 bit pixels and a byte shuffle for 16 bit ones
+	__attribute__((target("avx2")))
+	void rowRGBA_AVX2(const uint8_t * in, uint8_t * out, const void * table) {
+		__m256i colors = _mm256_broadcastsi128_si256(_mm_loadu_si128(static_cast<const __m128i *>(table)));
+
+		for (unsigned int x = 0; x < WIDTH; x += 8) {
+			__m256i shades = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + x)));
+			shades = _mm256_and_si256(shades, _mm256_set1_epi32(0x03));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x * 4), _mm256_permutevar8x32_epi32(colors, shades));
+		}
+	}
+
+	__attribute__((target("avx2")))
+	void rowRGB_AVX2(const uint8_t * in, uint8_t * out, const void * table) {
+		const std::array<uint8_t, 3> * rgb = static_cast<const std::array<uint8_t, 3> *>(table);
+		uint32_t rgba[4];
+		for (int i = 0; i < 4; i++) {
+			rgba[i] = rgb[i][0] | (rgb[i][1] << 8) | (rgb[i][2] << 16);
+		}
+		__m256i colors = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rgba)));
+
+		// Drops every fourth byte, packing each lane's 4 pixels into its low 12 bytes
+		const __m256i pack = _mm256_setr_epi8(
+			0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+			0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+		// Each block stores 28 bytes for 24 pixels worth, the last block is left to the scalar loop
+		unsigned int x = 0;
+		for (; x + 8 < WIDTH; x += 8) {
+			__m256i shades = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + x)));
+			shades = _mm256_and_si256(shades, _mm256_set1_epi32(0x03));
+			__m256i pixels = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(colors, shades), pack);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + x * 3), _mm256_castsi256_si128(pixels));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + x * 3 + 12), _mm256_extracti128_si256(pixels, 1));
+		}
+		for (; x < WIDTH; x++) {
+			std::memcpy(out + x * 3, rgb[in[x] & 0x03].data(), 3);
+		}
+	}
+
+	__attribute__((target("avx2")))
+	void row565_AVX2(const uint8_t * in, uint8_t * out, const void * table) {
+		uint64_t packed;
+		std::memcpy(&packed, table, 8);
+		__m256i colors = _mm256_set1_epi64x(packed);
+
+		for (unsigned int x = 0; x < WIDTH; x += 16) {
+			__m256i shades = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + x)));
+			shades = _mm256_and_si256(shades, _mm256_set1_epi16(0x03));
+			// Byte indices 2 * shade and 2 * shade + 1 of the color in each 16 bit lane
+			__m256i bytes = _mm256_add_epi16(_mm256_mullo_epi16(shades, _mm256_set1_epi16(0x0202)), _mm256_set1_epi16(0x0100));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x * 2), _mm256_shuffle_epi8(colors, bytes));
+		}
+	}
+#endif
+
+	struct Kernels {
+		RowKernel rgba;
+		RowKernel rgb;
+		RowKernel rgb565;
+	};
+
+	const Kernels SCALAR_KERNELS = {rowRGBA, rowRGB, row565};
+#if defined(PALETTE_X86) && defined(__SSE2__)
+	const Kernels SSE2_KERNELS = {rowRGBA_SSE2, rowRGB, row565_SSE2};
+#endif
+#ifdef PALETTE_X86
+	const Kernels AVX2_KERNELS = {rowRGBA_AVX2, rowRGB_AVX2, row565_AVX2};
+#endif
+
+	// nullptr if the build or the CPU does not support the set
+	const Kernels * findKernels(InstructionSet set) {
+		switch (set) {
+			case InstructionSet::Scalar:
+				return &SCALAR_KERNELS;
+			case InstructionSet::SSE2:
+#if defined(PALETTE_X86) && defined(__SSE2__)
+				return &SSE2_KERNELS;
+#endif
+				return nullptr;
+			case InstructionSet::AVX2:
+#ifdef PALETTE_X86
+				if (__builtin_cpu_supports("avx2")) {
+					return &AVX2_KERNELS;
+				}
+#endif
+				return nullptr;
+			default:
+				for (InstructionSet best : {InstructionSet::AVX2, InstructionSet::SSE2}) {
+					if (const Kernels * kernels = findKernels(best)) {
+						return kernels;
+					}
+				}
+				return &SCALAR_KERNELS;
+		}
+	}
+
+	const Kernels * const BEST_KERNELS = findKernels(InstructionSet::Best);
+}
+
+// Shades from white to black
+Palette::Palette()
+		: Palette({0xFFFFFF, 0xAAAAAA, 0x555555, 0x000000}) {}
+
+Palette::Palette(const std::array<uint32_t, 4>& colors)
+		: instructionSet(InstructionSet::Best) {
+	for (unsigned int shade = 0; shade < 4; shade++) {
+		setColor(shade, colors[shade]);
+	}
+}
+
+void Palette::setColor(unsigned int shade, uint32_t rgb) {
+	uint8_t r = (rgb >> 16) & 0xFF;
+	uint8_t g = (rgb >> 8) & 0xFF;
+	uint8_t b = rgb & 0xFF;
+	uint8_t bytes[4] = {r, g, b, 0xFF};
+
+	colors[shade] = rgb & 0xFFFFFF;
+	std::memcpy(&rgba[shade], bytes, 4);
+	this->rgb[shade] = {r, g, b};
+	rgb565[shade] = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+}
+
+uint32_t Palette::getColor(unsigned int shade) const {
+	return colors[shade];
+}
+
+bool Palette::setInstructionSet(InstructionSet set) {
+	if (!findKernels(set)) {
+		return false;
+	}
+
+	instructionSet = set;
+
+	return true;
+}
+
+void Palette::convert(const Display::FrameBuffer& frame, void * out, PixelFormat format, size_t pitch) const {
+	const Kernels& kernels = instructionSet == InstructionSet::Best ? *BEST_KERNELS : *findKernels(instructionSet);
+	RowKernel kernel;
+	const void * table;
+
+	switch (format) {
+		case PixelFormat::RGBA8888:
+			kernel = kernels.rgba;
+			table = rgba.data();
+			break;
+		case PixelFormat::RGB888:
+			kernel = kernels.rgb;
+			table = rgb.data();
+			break;
+		default:
+			kernel = kernels.rgb565;
+			table = rgb565.data();
+			break;
+	}
+
+	if (pitch == 0) {
+		pitch = WIDTH * getBytesPerPixel(format);
+	}
+
+	uint8_t * row = static_cast<uint8_t *>(out);
+	for (const auto& line : frame) {
+		kernel(line.data(), row, table);
+		row += pitch;
+	}
+}
+
+size_t Palette::getBytesPerPixel(PixelFormat format) {
+	switch (format) {
+		case PixelFormat::RGBA8888:
+			return 4;
+		case PixelFormat::RGB888:
+			return 3;
+		default:
+			return 2;
+	}
+}
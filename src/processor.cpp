@@ -1,11 +1,14 @@
 #include "processor.hpp"
 
 #include "instructions.hpp"
+#include "trace.hpp"
 
 #include <cstdio>
 
 Processor::Processor() {
 	cycles = 0;
+	totalCycles = 0;
+	locked = false;
 	registers.A = 0x0;
 	registers.B = 0x0;
 	registers.C = 0x0;
@@ -16,51 +19,75 @@ Processor::Processor() {
 	registers.L = 0x0;
 	registers.PC = 0x0;
 	registers.SP = 0x0;
+	registers.HALT = false;
 }
 
+// Per T-cycle interface, only executes an instruction once the previous one has used up its cycles
 void Processor::step() {
-	if (registers.PC == 0x100) {
-		printf("Boot ROM done, exiting...\n");
-		exit(0);
-	}
-	if (!registers.HALT) {
-		if (cycles == 0) {
-			uint8_t instructionByte = memory.read(registers.PC);
-			bool prefixByte = instructionByte == Instructions::PREFIX_BYTE;
-
-			if (prefixByte) {
-				instructionByte = memory.read(registers.PC + 1);
-			}
-
-			if (auto instruction = Instructions::ref().fetchInstruction(instructionByte, prefixByte)) {
-				// printf("Instruction: 0x%s%X;\tPC: 0x%X\n", prefixByte ? "CB" : "", instructionByte, registers.PC);
-				printf("A:0x%02X B:0x%02X C:0x%02X D:0x%02X E:0x%02X F:0x%02X H:0x%02X L:0x%02X | PC:0x%04X | SP:0x%04X | OP:0x%s%X\u001b[91D",
-					registers.A,
-					registers.B,
-					registers.C,
-					registers.D,
-					registers.E,
-					registers.F,
-					registers.H,
-					registers.L,
-					registers.PC,
-					registers.SP,
-					prefixByte ? "CB" : "--",
-					instructionByte
-				);
-				instruction(cycles, registers, memory);
-			}
-			else {
-				fprintf(stderr, "Invalid Instruction: 0x%s%X\n", prefixByte ? "CB" : "", instructionByte);
-			}
-		}
-	} else {
-		// TODO: exit halt
+	if (cycles == 0) {
+		cycles = execute();
 	}
 
 	cycles--;
 }
 
+// Executes a single instruction and returns the number of T-cycles it took
+unsigned int Processor::execute() {
+	if (registers.HALT || locked) {
+		totalCycles += 4;
+		return 4;  // TODO: exit halt
+	}
+
+	uint8_t instructionByte = memory.read(registers.PC);
+	bool prefixByte = instructionByte == Instructions::PREFIX_BYTE;
+
+	if (prefixByte) {
+		instructionByte = memory.read(registers.PC + 1);
+	}
+
+	unsigned int instructionCycles = 0;
+
+	if (auto instruction = Instructions::ref().fetchInstruction(instructionByte, prefixByte)) {
+#ifdef GAMEBOY_TRACE
+		Trace::ref().record({
+			totalCycles,
+			registers.PC,
+			(uint16_t) (registers.A << 8 | registers.F),
+			(uint16_t) (registers.B << 8 | registers.C),
+			(uint16_t) (registers.D << 8 | registers.E),
+			(uint16_t) (registers.H << 8 | registers.L),
+			registers.SP,
+			instructionByte,
+			prefixByte
+		});
+#endif
+		instruction(instructionCycles, registers, memory);
+	}
+	else {
+		fprintf(stderr, "Invalid Instruction: 0x%s%X\n", prefixByte ? "CB" : "", instructionByte);
+		locked = true;  // Illegal opcodes lock up the CPU
+	}
+
+	if (instructionCycles == 0) {
+		instructionCycles = 4;
+	}
+
+	totalCycles += instructionCycles;
+
+	return instructionCycles;
+}
+
+// Executes whole instructions until at least `budget` T-cycles have passed, returns the cycles used
+unsigned int Processor::run(unsigned int budget) {
+	unsigned int elapsed = 0;
+
+	while (elapsed < budget) {
+		elapsed += execute();
+	}
+
+	return elapsed;
+}
+
 MemoryBus& Processor::getMemory() {
 	return memory;
 }
@@ -4,12 +4,30 @@
 
 #include "texture.hpp"
 
+#define GL_GLEXT_PROTOTYPES
 #include <GL/gl.h>
+#include <GL/glext.h>
+
+namespace {
+	// x, y, u, v of a screen filling quad, v runs downwards so texture row 0 is the top of the screen
+	const float QUAD[] = {
+		-1.f, -1.f, 0.f, 1.f,
+		-1.f,  1.f, 0.f, 0.f,
+		 1.f,  1.f, 1.f, 0.f,
+		 1.f, -1.f, 1.f, 1.f
+	};
+}
 
-RenderDevice::RenderDevice(Window& window) {
+RenderDevice::RenderDevice(Window& window)
+		: quadBuffer(0) {
 	context = SDL_GL_CreateContext(window.getHandle());
 
 	glEnable(GL_TEXTURE_2D);
+
+	glGenBuffers(1, &quadBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void RenderDevice::clear() {
@@ -19,23 +37,20 @@ void RenderDevice::clear() {
 void RenderDevice::drawTexturedQuad(Texture& texture) {
 	glBindTexture(GL_TEXTURE_2D, texture.getID());
 
-	glBegin(GL_QUADS);
-
-	glTexCoord2f(0.f, 0.f);
-	glVertex2f(-1.f, -1.f);
-
-	glTexCoord2f(0.f, 1.f);
-	glVertex2f(-1.f, 1.f);
-
-	glTexCoord2f(1.f, 1.f);
-	glVertex2f(1.f, 1.f);
+	glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(2, GL_FLOAT, 4 * sizeof(float), nullptr);
+	glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(float), reinterpret_cast<const void*>(2 * sizeof(float)));
 
-	glTexCoord2f(1.f, 0.f);
-	glVertex2f(1.f, -1.f);
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
-	glEnd();
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 RenderDevice::~RenderDevice() {
+	glDeleteBuffers(1, &quadBuffer);
 	SDL_GL_DeleteContext(context);
 }
@@ -0,0 +1,100 @@
+#include "render-worker.hpp"
+
+namespace {
+	// Lines arrive a few microseconds apart, spinning that long is far cheaper than sleeping
+	const int SPIN_COUNT = 256;
+}
+
+RenderWorker::RenderWorker(Display& display)
+		: display(display)
+		, head(0)
+		, tail(0)
+		, running(true)
+		, sleeping(false) {
+	thread = std::thread(&RenderWorker::run, this);
+}
+
+// Queues a line and returns its ticket for waitFor()
+size_t RenderWorker::push(const Display::LineState& line) {
+	enqueue({line, false, 0});
+
+	return head.load(std::memory_order_relaxed);
+}
+
+// Publishes the frame once every line queued before has been drawn, see Display::publishFrame()
+void RenderWorker::publish(uint64_t frame) {
+	enqueue({Display::LineState(), true, frame});
+}
+
+// Blocks until the line with this ticket and everything queued before it is done, 0 never blocks
+void RenderWorker::waitFor(size_t ticket) {
+	while (tail.load(std::memory_order_acquire) < ticket) {
+		std::this_thread::yield();
+	}
+}
+
+// Blocks until everything queued is done
+void RenderWorker::wait() {
+	waitFor(head.load(std::memory_order_relaxed));
+}
+
+void RenderWorker::enqueue(const Job& job) {
+	size_t head = this->head.load(std::memory_order_relaxed);
+
+	// Only fills up if the worker falls more than a frame behind
+	while (head - tail.load(std::memory_order_acquire) == CAPACITY) {
+		std::this_thread::yield();
+	}
+
+	buffer[head & (CAPACITY - 1)] = job;
+	this->head.store(head + 1);
+
+	if (sleeping.load()) {
+		std::lock_guard<std::mutex> lock(mutex);
+		wake.notify_one();
+	}
+}
+
+void RenderWorker::run() {
+	size_t tail = 0;
+	int spins = 0;
+
+	while (true) {
+		if (tail == head.load(std::memory_order_acquire)) {
+			if (++spins < SPIN_COUNT) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mutex);
+			sleeping.store(true);
+			wake.wait(lock, [&]() { return head.load() != tail || !running.load(); });
+			sleeping.store(false);
+
+			if (head.load() == tail) {
+				return;  // Stopped with nothing left to draw
+			}
+		}
+
+		spins = 0;
+
+		const Job& job = buffer[tail & (CAPACITY - 1)];
+		if (job.publish) {
+			display.publishFrame(job.frame);
+		}
+		else {
+			display.drawScanline(job.line);
+		}
+
+		this->tail.store(++tail, std::memory_order_release);
+	}
+}
+
+RenderWorker::~RenderWorker() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running.store(false);
+	}
+	wake.notify_one();
+	thread.join();
+}
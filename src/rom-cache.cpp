@@ -0,0 +1,139 @@
+#include "rom-cache.hpp"
+
+#include <cstring>
+#include <ctime>
+#include <tuple>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+ROMCache::ROMCache() {}
+
+// Returns the shared image for the file's contents, nullptr if the file can't be read
+std::shared_ptr<const ROMImage> ROMCache::load(const std::string& filename) {
+	FileIdentity identity;
+	bool identified = identify(filename, identity);
+
+	// Same file, unchanged since it was loaded, skips reading and hashing it
+	if (identified) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = files.find(identity);
+		if (it != files.end()) {
+			if (auto shared = it->second.lock()) {
+				return shared;
+			}
+		}
+	}
+
+	ROMImage image;
+
+	if (!image.open(filename)) {
+		return nullptr;
+	}
+
+	uint64_t key = hash(image.data(), image.size());
+
+	// Only remember the identity if the file did not change while it was being read
+	FileIdentity opened;
+	identified = identified && identify(filename, opened) && opened == identity;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	prune();
+
+	// Compare the contents as well so a hash collision can never hand out the wrong ROM
+	std::shared_ptr<const ROMImage> shared;
+	auto range = images.equal_range(key);
+	for (auto it = range.first; it != range.second && !shared; it++) {
+		shared = it->second.lock();
+		if (shared && (shared->size() != image.size() || std::memcmp(shared->data(), image.data(), image.size()) != 0)) {
+			shared = nullptr;
+		}
+	}
+
+	if (!shared) {
+		shared = std::make_shared<const ROMImage>(std::move(image));
+		images.emplace(key, shared);
+	}
+
+	if (identified) {
+		files[identity] = shared;
+	}
+
+	return shared;
+}
+
+// Number of images currently shared
+size_t ROMCache::size() {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	prune();
+
+	return images.size();
+}
+
+ROMCache::~ROMCache() {
+
+}
+
+bool ROMCache::FileIdentity::operator<(const FileIdentity& other) const {
+	return std::tie(device, inode, size, modified) < std::tie(other.device, other.inode, other.size, other.modified);
+}
+
+bool ROMCache::FileIdentity::operator==(const FileIdentity& other) const {
+	return std::tie(device, inode, size, modified) == std::tie(other.device, other.inode, other.size, other.modified);
+}
+
+// False if the identity can't tell whether the contents changed: not a regular file, no inodes,
+// or modified so recently that another write within the same timestamp tick could follow
+bool ROMCache::identify(const std::string& filename, FileIdentity& identity) {
+#ifndef _WIN32
+	struct stat info;
+
+	if (stat(filename.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+		return false;
+	}
+	if (info.st_mtime + 2 > std::time(nullptr)) {
+		return false;
+	}
+
+	identity = {(uint64_t) info.st_dev, (uint64_t) info.st_ino, (uint64_t) info.st_size, (int64_t) info.st_mtime};
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+// 64-bit FNV-1a
+uint64_t ROMCache::hash(const uint8_t * data, size_t length) {
+	uint64_t hash = 0xCBF29CE484222325;
+
+	for (size_t i = 0; i < length; i++) {
+		hash ^= data[i];
+		hash *= 0x100000001B3;
+	}
+
+	return hash;
+}
+
+void ROMCache::prune() {
+	for (auto it = images.begin(); it != images.end();) {
+		if (it->second.expired()) {
+			it = images.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+	for (auto it = files.begin(); it != files.end();) {
+		if (it->second.expired()) {
+			it = files.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+}
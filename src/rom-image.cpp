@@ -0,0 +1,129 @@
+#include "rom-image.hpp"
+
+#include "cartridge.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ROMImage::ROMImage()
+		: mapping(nullptr)
+		, length(0) {}
+
+bool ROMImage::open(const std::string& filename) {
+	close();
+
+#ifndef _WIN32
+	int fd = ::open(filename.c_str(), O_RDONLY);
+
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+	bool mapped = fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && map(fd, info.st_size);
+
+	::close(fd);  // The mapping stays valid after the descriptor is closed
+
+	if (mapped) {
+		return true;
+	}
+#endif
+
+	return readBuffered(filename);
+}
+
+const uint8_t * ROMImage::data() const {
+	return mapping ? mapping : buffer.data();
+}
+
+size_t ROMImage::size() const {
+	return length;
+}
+
+bool ROMImage::isMapped() const {
+	return mapping != nullptr;
+}
+
+ROMImage::ROMImage(ROMImage&& other)
+		: mapping(other.mapping)
+		, length(other.length)
+		, buffer(std::move(other.buffer)) {
+	other.mapping = nullptr;
+	other.length = 0;
+}
+
+ROMImage& ROMImage::operator=(ROMImage&& other) {
+	if (this != &other) {
+		close();
+		mapping = other.mapping;
+		length = other.length;
+		buffer = std::move(other.buffer);
+		other.mapping = nullptr;
+		other.length = 0;
+	}
+
+	return *this;
+}
+
+ROMImage::~ROMImage() {
+	close();
+}
+
+// Only maps images the bank table can point into without running past the end of the file
+bool ROMImage::map(int fd, size_t fileSize) {
+#ifndef _WIN32
+	if (fileSize < 2 * ROM_BANK_SIZE || fileSize % ROM_BANK_SIZE != 0) {
+		return false;
+	}
+
+	void * address = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (address == MAP_FAILED) {
+		return false;
+	}
+
+	mapping = static_cast<const uint8_t *>(address);
+	length = fileSize;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+// Fallback for anything that can't be mapped, padded with zeroes to at least two whole banks
+bool ROMImage::readBuffered(const std::string& filename) {
+	std::ifstream file(filename, std::ios::binary);
+
+	if (!file) {
+		return false;
+	}
+
+	buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	size_t banks = std::max((buffer.size() + ROM_BANK_SIZE - 1) / ROM_BANK_SIZE, (size_t) 2);
+	buffer.resize(banks * ROM_BANK_SIZE, 0);
+	length = buffer.size();
+
+	return true;
+}
+
+void ROMImage::close() {
+#ifndef _WIN32
+	if (mapping) {
+		munmap(const_cast<uint8_t *>(mapping), length);
+	}
+#endif
+	mapping = nullptr;
+	length = 0;
+	buffer.clear();
+	buffer.shrink_to_fit();
+}
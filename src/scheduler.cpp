@@ -0,0 +1,76 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <functional>
+
+Scheduler::Scheduler()
+		: cycle(0) {
+	deadlines.fill(NEVER);
+	heap.reserve((size_t) Event::COUNT * 2);
+}
+
+uint64_t Scheduler::now() const {
+	return cycle;
+}
+
+void Scheduler::advance(unsigned int cycles) {
+	cycle += cycles;
+}
+
+void Scheduler::schedule(Event event, uint64_t timestamp) {
+	deadlines[(size_t) event] = timestamp;
+
+	heap.push_back({timestamp, event});
+	std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+}
+
+void Scheduler::cancel(Event event) {
+	deadlines[(size_t) event] = NEVER;
+}
+
+bool Scheduler::isScheduled(Event event) const {
+	return deadlines[(size_t) event] != NEVER;
+}
+
+uint64_t Scheduler::deadline(Event event) const {
+	return deadlines[(size_t) event];
+}
+
+// Timestamp of the earliest pending event, NEVER if nothing is scheduled
+uint64_t Scheduler::nextDeadline() {
+	discardStale();
+
+	return heap.empty() ? NEVER : heap.front().timestamp;
+}
+
+// Removes the earliest event if it is due, returns false when nothing is due yet
+bool Scheduler::popDue(Event& event) {
+	discardStale();
+
+	if (heap.empty() || heap.front().timestamp > cycle) {
+		return false;
+	}
+
+	event = heap.front().event;
+	deadlines[(size_t) event] = NEVER;
+
+	std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+	heap.pop_back();
+
+	return true;
+}
+
+void Scheduler::discardStale() {
+	while (!heap.empty() && deadlines[(size_t) heap.front().event] != heap.front().timestamp) {
+		std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+		heap.pop_back();
+	}
+}
+
+bool Scheduler::Entry::operator>(const Entry& other) const {
+	return timestamp > other.timestamp;
+}
+
+Scheduler::~Scheduler() {
+
+}
@@ -2,13 +2,20 @@
 
 #include "bitmap.hpp"
 
+#define GL_GLEXT_PROTOTYPES
 #include <GL/gl.h>
+#include <GL/glext.h>
 
 Texture::Texture(uint32_t width, uint32_t height, uint32_t internalFormat,
 			const void* data, uint32_t pixelFormat, uint32_t dataType)
 		: textureID(0)
 		, width(width)
-		, height(height) {
+		, height(height)
+		, pixelFormat(pixelFormat)
+		, dataType(dataType)
+		, pixelBuffers{0, 0}
+		, currentBuffer(0)
+		, pixelBuffersEnabled(false) {
 	glGenTextures(1, &textureID);
 	glBindTexture(GL_TEXTURE_2D, textureID);
 
@@ -17,6 +24,7 @@ Texture::Texture(uint32_t width, uint32_t height, uint32_t internalFormat,
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height,
 			0, pixelFormat, dataType, data);
 
@@ -32,6 +40,57 @@ uint32_t Texture::getID() {
 	return textureID;
 }
 
+void Texture::update(const void* data) {
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, pixelFormat, dataType, data);
+}
+
+void* Texture::beginUpdate() {
+	if (!pixelBuffersEnabled) {
+		staging.resize(getDataSize());
+		return staging.data();
+	}
+
+	currentBuffer ^= 1;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[currentBuffer]);
+	// Orphans the old storage instead of waiting for the GPU to finish reading it
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, getDataSize(), nullptr, GL_STREAM_DRAW);
+	void* data = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (!data) {
+		usePixelBuffers(false);  // Mapping failed, carry on with plain uploads
+		return beginUpdate();
+	}
+
+	return data;
+}
+
+void Texture::endUpdate() {
+	if (!pixelBuffersEnabled) {
+		update(staging.data());
+		return;
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[currentBuffer]);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	update(nullptr);  // Offset 0 into the bound pixel buffer
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void Texture::usePixelBuffers(bool enable) {
+	if (enable && !pixelBuffersEnabled) {
+		glGenBuffers(2, pixelBuffers);
+		staging = std::vector<uint8_t>();
+	}
+	else if (!enable && pixelBuffersEnabled) {
+		glDeleteBuffers(2, pixelBuffers);
+	}
+
+	pixelBuffersEnabled = enable;
+}
+
 uint32_t Texture::getWidth() const {
 	return width;
 }
@@ -40,6 +99,22 @@ uint32_t Texture::getHeight() const {
 	return height;
 }
 
+uint32_t Texture::getDataSize() const {
+	uint32_t bytesPerPixel;
+
+	switch (dataType) {
+		case GL_UNSIGNED_SHORT_5_6_5:
+			bytesPerPixel = 2;
+			break;
+		default:
+			bytesPerPixel = pixelFormat == GL_RGBA ? 4 : 3;
+			break;
+	}
+
+	return width * height * bytesPerPixel;
+}
+
 Texture::~Texture() {
+	usePixelBuffers(false);
 	glDeleteTextures(1, &textureID);
 }
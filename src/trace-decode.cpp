@@ -0,0 +1,23 @@
+#include "trace.hpp"
+
+#include <cstdio>
+
+// Offline decoder for binary traces written by a GAMEBOY_TRACE build
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+		return 1;
+	}
+
+	FILE * in = fopen(argv[1], "rb");
+
+	if (!in) {
+		fprintf(stderr, "Could not open trace file: %s\n", argv[1]);
+		return 1;
+	}
+
+	Trace::decode(in, stdout);
+	fclose(in);
+
+	return 0;
+}
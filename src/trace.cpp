@@ -0,0 +1,76 @@
+#include "trace.hpp"
+
+#include <algorithm>
+
+Trace::Trace()
+		: head(0)
+		, tail(0)
+		, dropped(0)
+		, file(nullptr) {}
+
+bool Trace::open(const std::string& filename) {
+	close();
+	file = fopen(filename.c_str(), "wb");
+
+	return file != nullptr;
+}
+
+// Writes all pending records to the trace file, returns the number of records written
+size_t Trace::flush() {
+	size_t tail = this->tail.load(std::memory_order_relaxed);
+	size_t head = this->head.load(std::memory_order_acquire);
+	size_t count = head - tail;
+
+	if (file) {
+		// Pending records can wrap around the end of the buffer, write them in at most two chunks
+		while (tail != head) {
+			size_t index = tail & (CAPACITY - 1);
+			size_t chunk = std::min(head - tail, CAPACITY - index);
+			fwrite(&buffer[index], sizeof(TraceRecord), chunk, file);
+			tail += chunk;
+		}
+	}
+
+	this->tail.store(head, std::memory_order_release);
+
+	return file ? count : 0;
+}
+
+void Trace::close() {
+	if (file) {
+		flush();
+		fclose(file);
+		file = nullptr;
+	}
+}
+
+uint64_t Trace::getDropped() const {
+	return dropped.load(std::memory_order_relaxed);
+}
+
+// Converts a binary trace into one line of text per instruction
+void Trace::decode(FILE * in, FILE * out) {
+	TraceRecord record;
+
+	while (fread(&record, sizeof(TraceRecord), 1, in) == 1) {
+		fprintf(out, "%012llu | A:0x%02X B:0x%02X C:0x%02X D:0x%02X E:0x%02X F:0x%02X H:0x%02X L:0x%02X | PC:0x%04X | SP:0x%04X | OP:0x%s%02X\n",
+			(unsigned long long) record.cycle,
+			record.AF >> 8,
+			record.BC >> 8,
+			record.BC & 0xFF,
+			record.DE >> 8,
+			record.DE & 0xFF,
+			record.AF & 0xFF,
+			record.HL >> 8,
+			record.HL & 0xFF,
+			record.PC,
+			record.SP,
+			record.prefixed ? "CB" : "--",
+			record.opcode
+		);
+	}
+}
+
+Trace::~Trace() {
+	close();
+}
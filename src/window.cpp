@@ -44,6 +44,18 @@ int Window::getHeight() const {
 	return height;
 }
 
+// Refresh rate in Hz of the display the window is on, 0 when the driver does not report one. SDL
+// rounds it to whole Hz, a 59.94 Hz display reports 60
+int Window::getRefreshRate() const {
+	SDL_DisplayMode mode;
+
+	if (SDL_GetWindowDisplayMode(window, &mode) != 0) {
+		return 0;
+	}
+
+	return mode.refresh_rate;
+}
+
 Window::~Window() {
 	delete renderDevice;
 	SDL_DestroyWindow(window);
@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+#include "emulation-thread.hpp"
+#include "motherboard.hpp"
+
+// Runs the generated cartridge on the emulation thread the way the UI does: input goes in through
+// the queue, frames are only read back through acquireFrame(). Once the cartridge runs, holding
+// Start has to invert its screen and releasing it has to bring the screen back, which takes the
+// press through InputQueue, Joypad and the cartridge's P1 group select. The thread then has to stop
+// when asked, the way closing the window stops it. Success is only reported by the last line of
+// output, so a process that is ended early by the core never passes.
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	// Polls frames until one satisfies the condition, false on timeout
+	bool waitForFrame(Motherboard& motherboard, Display::FrameBuffer& frame,
+			const std::function<bool(const Display::Frame&)>& condition) {
+		Clock::time_point timeout = Clock::now() + std::chrono::seconds(60);
+
+		while (Clock::now() < timeout) {
+			Display::Frame current = motherboard.acquireFrame();
+			if (condition(current)) {
+				frame = *current.pixels;
+				return true;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(16));
+		}
+
+		return false;
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <boot ROM> <ROM>\n", argv[0]);
+		return 1;
+	}
+
+	Motherboard motherboard;
+
+	if (!motherboard.loadCartridge(argv[2]) || !motherboard.loadBootROM(argv[1])) {
+		return 1;
+	}
+
+	EmulationThread emulation(motherboard);
+	emulation.setSpeed(0);  // The boot ROM alone takes 896 frames
+	emulation.start();
+
+	Display::FrameBuffer released;
+	Display::FrameBuffer pressed;
+	uint64_t shown = 0;
+
+	if (!waitForFrame(motherboard, released, [&](const Display::Frame& frame) {
+		shown = frame.sequence;
+		return frame.sequence >= 1200;
+	})) {
+		fprintf(stderr, "Only reached frame %llu\n", (unsigned long long) shown);
+		return 1;
+	}
+
+	emulation.getInput().push({Button::Start, true});
+
+	// Colour 0 and 3 swap places with the inverted palette, frames in between can be partly inverted
+	if (!waitForFrame(motherboard, pressed, [&](const Display::Frame& frame) {
+		for (unsigned int y = 0; y < 144; y++) {
+			for (unsigned int x = 0; x < 160; x++) {
+				if ((*frame.pixels)[y][x] != 3 - released[y][x]) {
+					return false;
+				}
+			}
+		}
+		return true;
+	})) {
+		fprintf(stderr, "Holding Start did not invert the screen\n");
+		return 1;
+	}
+
+	emulation.getInput().push({Button::Start, false});
+
+	Display::FrameBuffer restored;
+	if (!waitForFrame(motherboard, restored, [&](const Display::Frame& frame) {
+		shown = frame.sequence;
+		return *frame.pixels == released;
+	})) {
+		fprintf(stderr, "Releasing Start did not bring the screen back\n");
+		return 1;
+	}
+
+	Clock::time_point stopping = Clock::now();
+	emulation.stop();
+	double stopTime = std::chrono::duration<double>(Clock::now() - stopping).count();
+
+	if (stopTime >= 1.0) {
+		fprintf(stderr, "Stopping took %.3f s\n", stopTime);
+		return 1;
+	}
+
+	printf("emulation thread stopped after frame %llu in %.3f s\n", (unsigned long long) shown, stopTime);
+
+	return 0;
+}
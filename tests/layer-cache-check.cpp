@@ -0,0 +1,73 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "display.hpp"
+
+// Draws random background and window lines with and without the layer cache and requires identical output. Between
+// frames VRAM changes through writeVRAM(), or directly followed by invalidateTiles(), and LCDC
+// switches tile data areas and maps, so every way a cached layer can go stale is exercised.
+namespace {
+	Display plain;
+	Display cached;
+}
+
+int main() {
+	std::mt19937 rng(1);
+
+	for (Display * display : {&plain, &cached}) {
+		display->BGP = 0xE4;
+	}
+	cached.setLayerCache(true);
+
+	unsigned int lines = 0;
+
+	for (unsigned int frame = 0; frame < 500; frame++) {
+		if (frame % 50 == 0) {
+			for (unsigned int i = 0; i < 0x2000; i++) {
+				plain.VRAM[i] = cached.VRAM[i] = rng();
+			}
+			plain.invalidateTiles();
+			cached.invalidateTiles();
+		}
+		else {
+			for (unsigned int i = 0; i < 64; i++) {
+				uint16_t offset = rng() % 0x2000;
+				uint8_t byte = rng();
+				plain.writeVRAM(offset, byte);
+				cached.writeVRAM(offset, byte);
+			}
+		}
+
+		uint8_t lcdc = 0x81 | (rng() & 0x78);  // Background on, random maps and tile data area
+		uint8_t scx = rng();
+		uint8_t scy = rng();
+		uint8_t wx = rng() % 167;
+		uint8_t wy = rng() % 144;
+
+		for (Display * display : {&plain, &cached}) {
+			display->LCDC = lcdc;
+			display->SCX = scx;
+			display->SCY = scy;
+			display->WX = wx;
+			display->WY = wy;
+			display->windowLine = 0;
+		}
+
+		for (unsigned int y = 0; y < 144; y++, lines++) {
+			for (Display * display : {&plain, &cached}) {
+				display->LY = y;
+				display->drawScanline(display->captureLine());
+			}
+
+			if (std::memcmp(plain.frameBuffers[0][y].data(), cached.frameBuffers[0][y].data(), 160) != 0) {
+				fprintf(stderr, "Line %u of frame %u differs with the layer cache (LCDC %02X)\n", y, frame, lcdc);
+				return 1;
+			}
+		}
+	}
+
+	printf("layer cache matched %u lines\n", lines);
+
+	return 0;
+}
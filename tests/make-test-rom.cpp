@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+
+// Writes a 32K ROM-only cartridge that passes the boot ROM's checks and then draws a fixed pattern:
+// a row of striped tiles at the top with the boot logo left in VRAM below it, then keeps polling P1
+// and inverts BGP while Start is held. The logo the boot ROM compares against is copied out of the
+// boot ROM itself.
+namespace {
+	const uint8_t PROGRAM[] = {
+		0xF3,              // 0150 DI
+		0x31, 0xFE, 0xFF,  // 0151 LD SP,$FFFE
+		0xAF,              // 0154 XOR A
+		0xE0, 0x40,        // 0155 LDH ($40),A      LCD off
+		0x21, 0x10, 0x80,  // 0157 LD HL,$8010      Tile 1
+		0x06, 0x10,        // 015A LD B,16
+		0x3E, 0x55,        // 015C LD A,$55
+		0x22,              // 015E LD (HL+),A
+		0x05,              // 015F DEC B
+		0x20, 0xFC,        // 0160 JR NZ,$015E
+		0x21, 0x00, 0x98,  // 0162 LD HL,$9800      First map row
+		0x06, 0x14,        // 0165 LD B,20
+		0x3E, 0x01,        // 0167 LD A,1
+		0x22,              // 0169 LD (HL+),A
+		0x05,              // 016A DEC B
+		0x20, 0xFC,        // 016B JR NZ,$0169
+		0x3E, 0xE4,        // 016D LD A,$E4
+		0xE0, 0x47,        // 016F LDH ($47),A      BGP
+		0x3E, 0x91,        // 0171 LD A,$91
+		0xE0, 0x40,        // 0173 LDH ($40),A      LCD and background on
+		0xEA, 0xA0, 0xFE,  // 0175 LD ($FEA0),A     Unusable area, ignored
+		0xFA, 0xA0, 0xFE,  // 0178 LD A,($FEA0)
+		0xFB,              // 017B EI
+		0x3E, 0x10,        // 017C LD A,$10
+		0xE0, 0x00,        // 017E LDH ($00),A      P1, select the button group
+		0xF0, 0x00,        // 0180 LDH A,($00)
+		0xE6, 0x08,        // 0182 AND $08          Start, pressed reads 0
+		0x3E, 0xE4,        // 0184 LD A,$E4
+		0x20, 0x02,        // 0186 JR NZ,$018A
+		0x3E, 0x1B,        // 0188 LD A,$1B         Inverted
+		0xE0, 0x47,        // 018A LDH ($47),A      BGP
+		0x18, 0xEE,        // 018C JR $017C
+	};
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <boot ROM> <output ROM>\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<uint8_t> boot(0x100);
+	FILE * file = fopen(argv[1], "rb");
+	if (!file || fread(boot.data(), 1, boot.size(), file) != boot.size()) {
+		fprintf(stderr, "Could not read boot ROM: %s\n", argv[1]);
+		return 1;
+	}
+	fclose(file);
+
+	std::vector<uint8_t> rom(0x8000, 0);
+
+	const uint8_t entry[] = {0x00, 0xC3, 0x50, 0x01};  // NOP, JP $0150
+	std::copy(std::begin(entry), std::end(entry), rom.begin() + 0x100);
+	std::copy(boot.begin() + 0xA8, boot.begin() + 0xD8, rom.begin() + 0x104);  // Logo
+
+	const char title[] = "HEADLESS TEST";
+	std::copy(std::begin(title), std::end(title) - 1, rom.begin() + 0x134);
+
+	// 0x147-0x149 stay 0: ROM only, 32K, no RAM
+	uint8_t checksum = 0;
+	for (int i = 0x134; i <= 0x14C; i++) {
+		checksum = checksum - rom[i] - 1;
+	}
+	rom[0x14D] = checksum;
+
+	std::copy(std::begin(PROGRAM), std::end(PROGRAM), rom.begin() + 0x150);
+
+	file = fopen(argv[2], "wb");
+	if (!file || fwrite(rom.data(), 1, rom.size(), file) != rom.size()) {
+		fprintf(stderr, "Could not write ROM: %s\n", argv[2]);
+		return 1;
+	}
+	fclose(file);
+
+	return 0;
+}
@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "palette.hpp"
+
+// Converts frames that put every shade at every pixel position into all three formats, with a row
+// pitch larger than the row, and requires the SSE2 and AVX2 kernels to write exactly what the scalar
+// ones do. The scalar output itself is checked against the palette colors, and the padding between
+// rows has to stay untouched.
+namespace {
+	const unsigned int PADDING = 13;
+	const uint8_t UNTOUCHED = 0xA5;
+
+	std::vector<uint8_t> convert(const Palette& palette, const Display::FrameBuffer& frame, PixelFormat format) {
+		size_t pitch = 160 * Palette::getBytesPerPixel(format) + PADDING;
+		std::vector<uint8_t> out(144 * pitch, UNTOUCHED);
+		palette.convert(frame, out.data(), format, pitch);
+		return out;
+	}
+
+	// Bytes of a pixel the way each format stores it
+	std::vector<uint8_t> expected(uint32_t color, PixelFormat format) {
+		uint8_t r = color >> 16;
+		uint8_t g = color >> 8;
+		uint8_t b = color;
+
+		switch (format) {
+			case PixelFormat::RGBA8888:
+				return {r, g, b, 0xFF};
+			case PixelFormat::RGB888:
+				return {r, g, b};
+			default: {
+				uint16_t word = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+				std::vector<uint8_t> bytes(2);
+				std::memcpy(bytes.data(), &word, 2);
+				return bytes;
+			}
+		}
+	}
+}
+
+int main() {
+	static Display::FrameBuffer frame;
+	Palette palette({0x123456, 0x89ABCD, 0xFEDCBA, 0x0F1E2D});
+
+	const PixelFormat FORMATS[] = {PixelFormat::RGBA8888, PixelFormat::RGB888, PixelFormat::RGB565};
+	const InstructionSet SETS[] = {InstructionSet::SSE2, InstructionSet::AVX2};
+	const char * SET_NAMES[] = {"SSE2", "AVX2"};
+	bool tested[2] = {false, false};
+
+	for (unsigned int offset = 0; offset < 4; offset++) {
+		for (unsigned int y = 0; y < 144; y++) {
+			for (unsigned int x = 0; x < 160; x++) {
+				frame[y][x] = (x + y + offset) % 4;
+			}
+		}
+
+		for (PixelFormat format : FORMATS) {
+			size_t bytes = Palette::getBytesPerPixel(format);
+			size_t pitch = 160 * bytes + PADDING;
+
+			palette.setInstructionSet(InstructionSet::Scalar);
+			std::vector<uint8_t> scalar = convert(palette, frame, format);
+
+			for (unsigned int y = 0; y < 144; y++) {
+				for (unsigned int x = 0; x < 160; x++) {
+					std::vector<uint8_t> pixel = expected(palette.getColor(frame[y][x]), format);
+					if (std::memcmp(&scalar[y * pitch + x * bytes], pixel.data(), bytes) != 0) {
+						fprintf(stderr, "Scalar pixel %u,%u is wrong in format %d\n", x, y, static_cast<int>(format));
+						return 1;
+					}
+				}
+				for (unsigned int i = 160 * bytes; i < pitch; i++) {
+					if (scalar[y * pitch + i] != UNTOUCHED) {
+						fprintf(stderr, "Scalar kernel wrote past row %u in format %d\n", y, static_cast<int>(format));
+						return 1;
+					}
+				}
+			}
+
+			for (unsigned int i = 0; i < 2; i++) {
+				if (!palette.setInstructionSet(SETS[i])) {
+					continue;
+				}
+				tested[i] = true;
+
+				if (convert(palette, frame, format) != scalar) {
+					fprintf(stderr, "%s output differs from scalar in format %d\n", SET_NAMES[i], static_cast<int>(format));
+					return 1;
+				}
+			}
+		}
+	}
+
+	printf("palette kernels match scalar:");
+	for (unsigned int i = 0; i < 2; i++) {
+		printf(" %s %s", SET_NAMES[i], tested[i] ? "checked" : "not supported");
+	}
+	printf("\n");
+
+	return 0;
+}
@@ -0,0 +1,40 @@
+# Runs GameBoyHeadless and checks its exit code and output, ctest itself can only check one of the two.
+# RUNNER, ROM, BOOT, OPTIONS (space separated), EXPECT_CODE and EXPECT_OUTPUT (regex) are passed with -D.
+# OUTPUT_IMAGE, if set, is written with -o and has to be a complete 160x144 PPM afterwards.
+
+SEPARATE_ARGUMENTS(options UNIX_COMMAND "${OPTIONS}")
+
+IF(OUTPUT_IMAGE)
+	FILE(REMOVE "${OUTPUT_IMAGE}")
+	LIST(APPEND options -o "${OUTPUT_IMAGE}")
+ENDIF()
+
+EXECUTE_PROCESS(
+	COMMAND "${RUNNER}" -f "${ROM}" -b "${BOOT}" ${options}
+	RESULT_VARIABLE code
+	OUTPUT_VARIABLE output
+	ERROR_VARIABLE error
+)
+
+MESSAGE("${output}${error}")
+
+IF(NOT "${code}" STREQUAL "${EXPECT_CODE}")
+	MESSAGE(FATAL_ERROR "Exit code ${code}, expected ${EXPECT_CODE}")
+ENDIF()
+
+IF(NOT output MATCHES "${EXPECT_OUTPUT}")
+	MESSAGE(FATAL_ERROR "Output does not match: ${EXPECT_OUTPUT}")
+ENDIF()
+
+IF(OUTPUT_IMAGE)
+	IF(NOT EXISTS "${OUTPUT_IMAGE}")
+		MESSAGE(FATAL_ERROR "No image written to ${OUTPUT_IMAGE}")
+	ENDIF()
+
+	FILE(READ "${OUTPUT_IMAGE}" image HEX)
+	STRING(LENGTH "${image}" size)
+	MATH(EXPR size "${size} / 2")
+	IF(NOT size EQUAL 69135)  # Header plus 160 * 144 * 3
+		MESSAGE(FATAL_ERROR "Image has ${size} bytes")
+	ENDIF()
+ENDIF()